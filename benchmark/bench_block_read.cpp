@@ -0,0 +1,72 @@
+#include "../include/block/block_cache.h"
+#include "../include/const.h"
+#include "../include/sst/sst.h"
+#include "../include/sst/sst_iterator.h"
+#include "../include/utils/buffer_pool.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+// 缓存很小时反复扫描 SST，每个 block 都要从文件读取、解码，随后被淘汰
+// 对比缓冲区池关闭(容量为 0)和开启时的耗时与分配次数
+
+static const int KEY_NUM = 200000;
+static const int SCAN_ROUNDS = 10;
+static const char *DATA_DIR = "bench_block_read_data";
+
+static void run(const char *name, std::shared_ptr<SST> sst, size_t pool_capacity)
+{
+    auto &pool = BufferPool::global();
+    pool.clear();
+    pool.set_capacity(pool_capacity);
+    pool.reset_stats();
+
+    size_t count = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < SCAN_ROUNDS; round++)
+    {
+        for (auto it = sst->begin(0); it.is_valid(); ++it)
+        {
+            count++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto stats = pool.stats();
+    printf("%-8s blocks read=%zu time=%.1f us/block buffers: new=%llu reused=%llu objects: new=%llu reused=%llu (%zu entries)\n",
+           name, sst->num_blocks() * SCAN_ROUNDS, seconds * 1e6 / (sst->num_blocks() * SCAN_ROUNDS),
+           static_cast<unsigned long long>(stats.allocations), static_cast<unsigned long long>(stats.reuses),
+           static_cast<unsigned long long>(stats.object_allocations), static_cast<unsigned long long>(stats.object_reuses),
+           count);
+}
+
+int main()
+{
+    std::filesystem::remove_all(DATA_DIR);
+    std::filesystem::create_directories(DATA_DIR);
+
+    for (auto compression : {CompressionType::None, CompressionType::LZ})
+    {
+        // 容量很小的缓存，扫描时 block 不断被淘汰
+        auto cache = std::make_shared<BlockCache>(8, LSM_BLOCK_CACHE_K);
+        SSTBuilder builder(LSM_BLOCK_MEM_LIMIT, true, compression);
+        char key[32];
+        for (int i = 0; i < KEY_NUM; i++)
+        {
+            snprintf(key, sizeof(key), "key%08d", i);
+            builder.add(key, "value_" + std::to_string(i) + "_payload_payload_payload", 1);
+        }
+        auto sst = builder.build(compression == CompressionType::None ? 0 : 1,
+                                 std::string(DATA_DIR) + "/sst_bench", cache);
+
+        printf("compression=%s\n", compression == CompressionType::None ? "none" : "lz");
+        run("no pool", sst, 0);
+        run("pool", sst, LSM_BUFFER_POOL_CAPACITY);
+        sst->del_sst();
+    }
+
+    std::filesystem::remove_all(DATA_DIR);
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "../include/block/block.h"
+#include "../include/block/key_prefix_index.h"
+#include "../include/const.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// block 内和 block 索引上的随机点查：
+// 原来的二分查找(构建中的 block 在重启点上二分，BlockMeta 上按 first_key/last_key 二分)
+// 与解码时建立的 KeyPrefixIndex(定长前缀 + Eytzinger 顺序)对比
+// key 分为短的随机 key 和带长公共前缀的 redis key 两种
+
+static const int BLOCK_NUM = 2000;
+static const int META_NUM = 200000;
+static const int LOOKUP_NUM = 2000000;
+
+static std::vector<std::string> make_keys(std::mt19937_64 &gen, size_t n, bool redis)
+{
+    std::vector<std::string> keys;
+    char buf[32];
+    for (size_t i = 0; i < n; i++)
+    {
+        snprintf(buf, sizeof(buf), "%012llu", static_cast<unsigned long long>(gen() % 1000000000000ULL));
+        keys.push_back(redis ? std::string(REDIS_HASH_HEADER) + "user:" + buf : std::string(buf));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+template <typename F>
+static double measure(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void bench_blocks(const char *name, std::mt19937_64 &gen, bool redis)
+{
+    // 每个 block 写满 LSM_BLOCK_MEM_LIMIT，记录下每个 block 中的 key 用来生成查询
+    auto keys = make_keys(gen, BLOCK_NUM * 1000, redis);
+    std::vector<std::shared_ptr<Block>> building;
+    std::vector<std::shared_ptr<Block>> decoded;
+    std::vector<std::pair<size_t, std::string>> lookups_pool;
+    auto block = std::make_shared<Block>(LSM_BLOCK_MEM_LIMIT);
+    for (auto &key : keys)
+    {
+        if (!block->add_entry(key, "value", 1, false))
+        {
+            decoded.push_back(Block::decode(block->encode()));
+            building.push_back(block);
+            if (building.size() == BLOCK_NUM)
+            {
+                break;
+            }
+            block = std::make_shared<Block>(LSM_BLOCK_MEM_LIMIT);
+            block->add_entry(key, "value", 1, false);
+        }
+        lookups_pool.emplace_back(building.size(), key);
+    }
+    while (!lookups_pool.empty() && lookups_pool.back().first >= building.size())
+    {
+        lookups_pool.pop_back();
+    }
+
+    std::vector<std::pair<size_t, std::string>> lookups;
+    lookups.reserve(LOOKUP_NUM);
+    for (int i = 0; i < LOOKUP_NUM; i++)
+    {
+        lookups.push_back(lookups_pool[gen() % lookups_pool.size()]);
+    }
+
+    size_t found_binary = 0;
+    double binary = measure([&]
+                            {
+        for (auto &[idx, key] : lookups)
+        {
+            found_binary += building[idx]->get_idx_binary(key, 0).has_value();
+        } });
+    size_t found_index = 0;
+    double indexed = measure([&]
+                             {
+        for (auto &[idx, key] : lookups)
+        {
+            found_index += decoded[idx]->get_idx_binary(key, 0).has_value();
+        } });
+    printf("block %-6s entries/block=%zu binary=%.1f ns/op prefix_index=%.1f ns/op (found %zu/%zu)\n", name,
+           decoded.front()->size(), binary * 1e9 / LOOKUP_NUM, indexed * 1e9 / LOOKUP_NUM, found_binary, found_index);
+}
+
+// 改动前 BlockMeta 中保存的完整首尾 key
+struct KeyRange
+{
+    std::string first_key;
+    std::string last_key;
+};
+
+static size_t old_find_block_idx(const std::vector<KeyRange> &meta_entries, const std::string &key)
+{
+    // 改动前 SST::find_block_idx 的二分查找
+    int left = 0, right = meta_entries.size() - 1;
+    while (left <= right)
+    {
+        int mid = left + (right - left) / 2;
+        const auto &meta = meta_entries[mid];
+        if (key < meta.first_key)
+        {
+            right = mid - 1;
+        }
+        else if (key > meta.last_key)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            return mid;
+        }
+    }
+    return left;
+}
+
+static void bench_meta(const char *name, std::mt19937_64 &gen, bool redis)
+{
+    // 每个 block 4 个 key，只保留首尾
+    auto keys = make_keys(gen, META_NUM * 4, redis);
+    std::vector<KeyRange> meta_entries;
+    for (size_t i = 0; i + 3 < keys.size(); i += 4)
+    {
+        meta_entries.push_back({keys[i], keys[i + 3]});
+    }
+    std::vector<std::string_view> last_keys;
+    for (auto &meta : meta_entries)
+    {
+        last_keys.push_back(meta.last_key);
+    }
+    KeyPrefixIndex index;
+    index.build(last_keys);
+
+    std::vector<std::string> lookups;
+    lookups.reserve(LOOKUP_NUM);
+    for (int i = 0; i < LOOKUP_NUM; i++)
+    {
+        lookups.push_back(keys[gen() % keys.size()]);
+    }
+
+    size_t sum_binary = 0;
+    double binary = measure([&]
+                            {
+        for (auto &key : lookups)
+        {
+            sum_binary += old_find_block_idx(meta_entries, key);
+        } });
+    size_t sum_index = 0;
+    double indexed = measure([&]
+                             {
+        for (auto &key : lookups)
+        {
+            sum_index += index.lower_bound(key, [&](size_t i) -> std::string_view
+                                           { return meta_entries[i].last_key; });
+        } });
+    printf("meta  %-6s blocks=%zu binary=%.1f ns/op prefix_index=%.1f ns/op (%s)\n", name, meta_entries.size(),
+           binary * 1e9 / LOOKUP_NUM, indexed * 1e9 / LOOKUP_NUM, sum_binary == sum_index ? "same result" : "MISMATCH");
+}
+
+int main()
+{
+    std::mt19937_64 gen(42);
+    bench_blocks("short", gen, false);
+    bench_blocks("redis", gen, true);
+    bench_meta("short", gen, false);
+    bench_meta("redis", gen, true);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "../include/memtable/memtable.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// memtable 多线程写入吞吐测试
+// 每个线程写入互不重叠的 key，统计不同线程数下每秒写入的条数
+
+static const int TOTAL_KEYS = 800000;
+
+static double bench_put(int thread_num)
+{
+    Memtable memtable;
+    int per_thread = TOTAL_KEYS / thread_num;
+    std::string value(64, 'v');
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++)
+    {
+        threads.emplace_back([&memtable, &value, t, per_thread]()
+                             {
+            char key[32];
+            for (int i = 0; i < per_thread; i++)
+            {
+                snprintf(key, sizeof(key), "key%08d_%02d", i, t);
+                memtable.put(key, value, 0);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return per_thread * thread_num / seconds;
+}
+
+int main()
+{
+    printf("%-10s %16s\n", "threads", "puts/s");
+    for (int thread_num : {1, 2, 4, 8})
+    {
+        printf("%-10d %16.0f\n", thread_num, bench_put(thread_num));
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "../include/const.h"
+#include "../include/memtable/memtable_rep.h"
+#include "../include/skiplist/skiplist.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// 不同 memtable 存储结构的写入、点查和全表遍历性能
+// key 分为短的随机 key 和带长公共前缀的 redis key 两种
+
+static const int KEY_NUM = 500000;
+
+static std::vector<std::string> make_keys(std::mt19937_64 &gen, bool redis)
+{
+    std::vector<std::string> keys;
+    char buf[32];
+    for (int i = 0; i < KEY_NUM; i++)
+    {
+        uint64_t r = gen();
+        snprintf(buf, sizeof(buf), "%012llu", static_cast<unsigned long long>(r % 1000000000000ULL));
+        if (redis)
+        {
+            keys.push_back(std::string(REDIS_HASH_HEADER) + "user:" + std::to_string(r % 16) + "_field" + buf);
+        }
+        else
+        {
+            keys.push_back(buf);
+        }
+    }
+    return keys;
+}
+
+static void run(const char *rep_name, MemTableRepType type, const char *key_name, const std::vector<std::string> &keys, std::mt19937_64 &gen)
+{
+    auto rep = new_memtable_rep(type);
+    auto start = std::chrono::steady_clock::now();
+    for (auto &key : keys)
+    {
+        rep->put(key, "value", 0);
+    }
+    double put_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> lookups(keys);
+    std::shuffle(lookups.begin(), lookups.end(), gen);
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto &key : lookups)
+    {
+        found += rep->get(key, 0).is_valid();
+    }
+    double get_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // 第一次遍历包含哈希表排序、ART 生成快照的开销
+    size_t scanned = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto it = rep->begin(); it.is_valid(); ++it)
+    {
+        scanned++;
+    }
+    double scan_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-10s %-6s %12.0f %12.0f %10.1f %10zu %10zu %8zu\n", rep_name, key_name, keys.size() / put_seconds,
+           lookups.size() / get_seconds, scan_seconds * 1000, found, scanned, rep->get_memory_usage() >> 20);
+}
+
+int main()
+{
+    std::mt19937_64 gen(42);
+    auto short_keys = make_keys(gen, false);
+    auto redis_keys = make_keys(gen, true);
+
+    printf("%-10s %-6s %12s %12s %10s %10s %10s %8s\n", "rep", "keys", "puts/s", "gets/s", "scan(ms)", "found", "scanned", "mem(MB)");
+    std::pair<const char *, MemTableRepType> reps[] = {
+        {"skiplist", MemTableRepType::SkipList},
+        {"hash", MemTableRepType::HashTable},
+        {"art", MemTableRepType::Art},
+    };
+    for (auto &[name, type] : reps)
+    {
+        run(name, type, "short", short_keys, gen);
+        run(name, type, "redis", redis_keys, gen);
+    }
+    return 0;
+}
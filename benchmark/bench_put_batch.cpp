@@ -0,0 +1,77 @@
+#include "../include/skiplist/skiplist.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// 跳表批量写入测试
+// 对比逐个 put 与 put_batch(排序 + finger search) 写入同一组随机 key 的耗时
+
+static const int PRELOAD_KEYS = 200000;
+static const int BATCH_SIZE = 10000;
+static const int BATCH_NUM = 20;
+
+static std::string make_key(uint64_t n)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "key%016llu", static_cast<unsigned long long>(n));
+    return buf;
+}
+
+static void preload(SkipList &skiplist)
+{
+    std::string value(32, 'v');
+    for (int i = 0; i < PRELOAD_KEYS; i++)
+    {
+        skiplist.put(make_key(static_cast<uint64_t>(i) * 1000), value, 0);
+    }
+}
+
+int main()
+{
+    std::mt19937_64 gen(42);
+    std::vector<std::vector<std::string>> batches(BATCH_NUM);
+    for (auto &batch : batches)
+    {
+        for (int i = 0; i < BATCH_SIZE; i++)
+        {
+            batch.push_back(make_key(gen() % (static_cast<uint64_t>(PRELOAD_KEYS) * 1000)));
+        }
+    }
+    std::string value(32, 'v');
+
+    SkipList single;
+    preload(single);
+    auto start = std::chrono::steady_clock::now();
+    for (auto &batch : batches)
+    {
+        for (auto &key : batch)
+        {
+            single.put(key, value, 0);
+        }
+    }
+    double single_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    SkipList batched;
+    preload(batched);
+    start = std::chrono::steady_clock::now();
+    for (auto &batch : batches)
+    {
+        std::vector<std::pair<std::string_view, std::string_view>> kvs;
+        kvs.reserve(batch.size());
+        for (auto &key : batch)
+        {
+            kvs.emplace_back(key, value);
+        }
+        batched.put_batch(std::move(kvs), 0);
+    }
+    double batch_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int total = BATCH_SIZE * BATCH_NUM;
+    printf("%-12s %12s %14s\n", "mode", "seconds", "puts/s");
+    printf("%-12s %12.3f %14.0f\n", "put", single_seconds, total / single_seconds);
+    printf("%-12s %12.3f %14.0f\n", "put_batch", batch_seconds, total / batch_seconds);
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "../include/const.h"
+#include "../include/skiplist/skiplist.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// 跳表在不同 key 形态下的读写性能
+// redis_wrapper 生成的 key 带有很长的公共前缀(REDIS_HASH_HEADER_ 等)，
+// 与短的随机 key 对比，观察 key 比较在查找中的开销
+
+static const int KEY_NUM = 500000;
+
+static std::vector<std::string> short_keys(std::mt19937_64 &gen)
+{
+    std::vector<std::string> keys;
+    char buf[32];
+    for (int i = 0; i < KEY_NUM; i++)
+    {
+        snprintf(buf, sizeof(buf), "%012llu", static_cast<unsigned long long>(gen() % 1000000000000ULL));
+        keys.push_back(buf);
+    }
+    return keys;
+}
+
+// 模拟 hset / zadd / sadd 产生的 key：少量的 redis key，每个 key 下有大量的 field
+static std::vector<std::string> redis_keys(std::mt19937_64 &gen)
+{
+    std::vector<std::string> keys;
+    char buf[32];
+    for (int i = 0; i < KEY_NUM; i++)
+    {
+        uint64_t r = gen();
+        snprintf(buf, sizeof(buf), "%08llu", static_cast<unsigned long long>(r % 100000000));
+        std::string user = "user:" + std::to_string(r % 16);
+        switch (i % 3)
+        {
+        case 0:
+            keys.push_back(std::string(REDIS_HASH_HEADER) + user + "_field" + buf);
+            break;
+        case 1:
+            keys.push_back(std::string(REDIS_SORTED_SET_PREFIX) + user + "_SCORE_" + buf);
+            break;
+        default:
+            keys.push_back(std::string(REDIS_SET_PREFIX) + user + "_" + buf);
+            break;
+        }
+    }
+    return keys;
+}
+
+static void run(const char *name, const std::vector<std::string> &keys, std::mt19937_64 &gen)
+{
+    SkipList skiplist;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &key : keys)
+    {
+        skiplist.put(key, "value", 0);
+    }
+    double put_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> lookups(keys);
+    std::shuffle(lookups.begin(), lookups.end(), gen);
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto &key : lookups)
+    {
+        found += skiplist.get(key, 0).is_valid();
+    }
+    double get_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-8s %14.0f %14.0f %10zu\n", name, keys.size() / put_seconds, lookups.size() / get_seconds, found);
+}
+
+int main()
+{
+    std::mt19937_64 gen(42);
+    printf("%-8s %14s %14s %10s\n", "keys", "puts/s", "gets/s", "found");
+    run("short", short_keys(gen), gen);
+    run("redis", redis_keys(gen), gen);
+    return 0;
+}
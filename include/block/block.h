@@ -1,54 +1,108 @@
 #pragma once
 #include <memory>
 #include <cstring>
+#include <optional>
+#include <string>
 #include <vector>
+#include <string_view>
 #include <functional>
 #include "block_iterator.h"
+#include "key_prefix_index.h"
 
+// 编码格式：
+// | entry | entry | ... | restart[0] | ... | restart[n-1] | num_restarts(uint32_t) | num_entries(uint32_t) |
+// entry: | shared_len(varint) | unshared_len(varint) | value_len(varint) | key 的后缀 | value | tranc_id(varint) |
+// 长度和事务 id 都是变长整数(见 utils/varint.h)，小记录的额外开销只有几个字节，key 和 value 的长度没有上限
+// 重启点是 uint32_t 的偏移，二分查找时需要定长才能随机访问
+//
+// key 只保存与上一条记录不同的后缀，shared_len 是与上一条记录相同的前缀长度
+// 每隔 LSM_BLOCK_RESTART_INTERVAL 条记录设置一个重启点，重启点处的记录保存完整的 key(shared_len = 0)，
+// 查找时先在重启点上二分，再从重启点开始顺序解码
+//
+// 可选的哈希索引用于点查，位于重启点数组和 num_restarts 之间，此时 num_restarts 的最高位为 1：
+// | ... | restart[n-1] | bucket[0] | ... | bucket[m-1] | num_buckets(uint16_t) | num_restarts | num_entries |
+// bucket(uint8_t) 是哈希到该桶的 key 的第一条记录所在的重启点，
+// 没有 key 时为 HASH_EMPTY，多个重启点冲突时为 HASH_COLLISION，冲突时退回二分查找
 class Block : public std::enable_shared_from_this<Block>
 {
     friend BlockIterator;
+    // 构建时只保存记录，重启点在 restarts 中；
+    // 解码得到的 block 直接接管读出的整段编码，重启点在用到时才从 data 中读取，不再复制
     std::vector<uint8_t> data;
-    std::vector<uint16_t> offsets;
+    std::vector<uint32_t> restarts; // 构建时每个重启点记录的偏移
+    bool decoded = false;
+    size_t restarts_offset = 0; // 解码后重启点数组在 data 中的偏移
+    size_t num_restarts = 0;
+    size_t num_entries = 0;
     size_t capacity; // 容量
+    std::string last_key; // 构建时上一条记录的 key
 
+    bool with_hash_index = false;
+    std::vector<std::pair<size_t, uint8_t>> key_hashes; // 构建时每个 key 的哈希值和第一条记录所在的重启点
+    size_t hash_index_offset = 0; // 解码后哈希桶在 data 中的偏移
+    size_t num_buckets = 0;       // 解码后哈希桶的数量，0 表示没有哈希索引
+    KeyPrefixIndex restart_index; // 解码时在重启点的 key 上建立，点查时代替二分查找
+
+    // 从 offset 处解码出的一条记录，value 指向 data 中的数据
     struct Entry
     {
-        std::string key;
-        std::string value;
+        size_t shared_len;
+        std::string_view key_suffix;
+        std::string_view value;
         uint64_t tranc_id;
+        size_t next_offset; // 下一条记录的偏移
     };
 
-    // 在指定偏移处解码键值对
-    size_t get_offset_at(size_t idx) const;
-    Entry get_entry_at(size_t offset) const;
-    std::string get_key_at(size_t offset) const;
-    std::string get_value_at(size_t offset) const;
-    uint64_t get_tranc_id_at(size_t offset) const;
-    int adjust_idx_by_tranc_id(size_t idx, uint64_t tranc_id);
-    bool is_same_key(size_t idx, const std::string &target_key) const;
+    Entry decode_entry(size_t offset) const;
+    size_t get_restart(size_t restart_idx) const; // 第 restart_idx 个重启点记录的偏移
+    std::string_view get_restart_key(size_t restart_idx) const;
+    // 二分查找最后一个满足 before(key) 的重启点，before 在重启点上单调(先 true 后 false)，都不满足时返回 0
+    template <typename Before>
+    size_t find_restart(Before before) const;
+    size_t seek_restart(std::string_view key) const; // 最后一个 key 小于目标的重启点，都不小于时返回 0
+    size_t hash_index_size() const; // 构建时哈希索引编码后的大小，不生成索引时为 0
+    // 从 restart_idx 开始顺序查找，bounded 为 true 时 key 的第一条记录必须在这个重启段中
+    bool scan(std::string_view key, uint64_t tranc_id, size_t restart_idx, bool bounded, size_t &idx, Entry &entry) const;
+    // 查找 key 中事务 id 不大于 tranc_id 的最新记录，tranc_id 为 0 时返回最新的记录
+    bool seek(std::string_view key, uint64_t tranc_id, size_t &idx, Entry &entry) const;
+    // 与 seek 相同，有哈希索引时先通过索引定位重启点
+    bool seek_point(std::string_view key, uint64_t tranc_id, size_t &idx, Entry &entry) const;
 
 public:
     Block() = default;
-    Block(size_t capacity);
+    Block(size_t capacity, bool with_hash_index = false);
+    ~Block(); // data 归还到 BufferPool::global()
+    Block(Block &&) = default;
+    Block &operator=(Block &&) = default;
 
     size_t cur_size() const; // 获取的是容量大小，而不是键值对的数量
     size_t size();           // 获取的是键值对的数量
     bool is_empty() const;
 
     std::vector<uint8_t> encode();
-    static std::shared_ptr<Block> decode(const std::vector<uint8_t> &encode, bool with_hash = false);
+    // encoded 被 block 接管，调用方传入右值即可避免复制
+    // with_hash 为 true 时 encoded 末尾带有 CRC32C(uint32_t)，先校验再解码
+    static std::shared_ptr<Block> decode(std::vector<uint8_t> encoded, bool with_hash = false);
 
     std::string get_first_key();
-    std::optional<std::string> get_value_binary(const std::string &key, uint64_t tranc_id = 0);
+    std::optional<std::string> get_value_binary(std::string_view key, uint64_t tranc_id = 0);
+    // 返回的 value 指向 block 中的数据，block 存活期间有效
+    std::optional<std::string_view> get_value_view(std::string_view key, uint64_t tranc_id = 0) const;
+
+    bool add_entry(std::string_view key, std::string_view value, uint64_t tranc_id, bool force_write);
 
-    bool add_entry(const std::string key, const std::string &value, uint64_t tranc_id, bool force_write);
+    // 第一条 key 不小于 key 的记录的下标，value 指向该记录的 value，都小于 key 时返回 size()
+    // 用于 key 不重复的 block(例如 SST 的索引块)
+    size_t lower_bound(std::string_view key, std::string_view &value) const;
+    // 第 idx 条记录的 value，block 存活期间有效
+    std::string_view value_at(size_t idx) const;
+    // 第一条不满足 before(key) 的记录的下标，before 在记录上单调(先 true 后 false)，都满足时返回 size()
+    size_t partition_point(const std::function<bool(std::string_view)> &before) const;
 
-    std::optional<size_t> get_idx_binary(const std::string &key, uint64_t tranc_id);
-    int compare_key(size_t offset, const std::string &target);
+    std::optional<size_t> get_idx_binary(std::string_view key, uint64_t tranc_id);
 
     std::optional<std::pair<std::shared_ptr<BlockIterator>, std::shared_ptr<BlockIterator>>> get_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate);
 
     BlockIterator begin(uint64_t tranc_id = 0);
     BlockIterator end(uint64_t tranc_id = 0);
-};
\ No newline at end of file
+};
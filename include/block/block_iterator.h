@@ -3,24 +3,34 @@
 #include "../iterator/iterator.h"
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 
 class Block;
+// block 中的记录只保存与上一条记录不同的 key 后缀，迭代器顺序解码，逐条还原完整的 key
 class BlockIterator : public BaseIterator
 {
+    friend Block;
     using value_type = std::pair<std::string, std::string>;
     using pointer = value_type *;
 
 private:
     std::shared_ptr<Block> block;
     size_t current_index;
+    size_t next_offset;           // 下一条记录在 block 中的偏移
+    std::string current_key;      // 当前记录完整的 key
+    std::string_view current_value; // 指向 block 中的数据
+    uint64_t current_tranc_id = 0;
     mutable std::optional<value_type> cached_value;
     uint64_t max_tranc_id_;
 
+    void seek_index(size_t index); // 从所在的重启点开始解码到第 index 条记录
+    void decode_next();            // 解码 next_offset 处的记录，current_key 中是上一条记录的 key
+
 public:
     BlockIterator(std::shared_ptr<Block> b, size_t index, uint64_t tranc_id);
-    BlockIterator(std::shared_ptr<Block> b, const std::string &key, uint64_t tranc_id);
+    BlockIterator(std::shared_ptr<Block> b, std::string_view key, uint64_t tranc_id);
 
     BlockIterator::pointer operator->() const;
 
@@ -33,5 +43,10 @@ public:
     virtual bool is_valid() const override;
     virtual uint64_t get_tranc_id() const override;
 
+    // 不复制数据的访问方式，key 在迭代器移动前有效，value 在 block 存活期间有效
+    std::string_view key() const;
+    std::string_view value() const;
+    size_t get_index() const; // 当前记录在 block 中的序号，到达末尾时等于记录数
+
     void update_current() const;
-};
\ No newline at end of file
+};
@@ -1,18 +1,29 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// block 在 SST 文件中的位置，作为索引项的 value 编码为：
+// | offset(varint) | size(varint) |
+// size 包括 block 尾部的压缩类型和校验值
 class BlockMeta
 {
 public:
     size_t offset; // block在sst文件中的偏移量
-    std::string first_key;
-    std::string last_key;
+    size_t size;
 
     BlockMeta();
-    BlockMeta(size_t offset, const std::string &first_key, const std::string &last_key);
+    BlockMeta(size_t offset, size_t size);
 
-    static void encode_meta_to_slice(std::vector<BlockMeta> &meta_entries, std::vector<uint8_t> &metadata);
+    void encode_to(std::string &out) const;
+    // 从 data 的开头解码，返回解码后剩下的部分，数据损坏时抛出 std::runtime_error
+    static std::string_view decode_from(std::string_view data, BlockMeta &meta);
 
-    static std::vector<BlockMeta> decode_meta_from_slice(const std::vector<uint8_t> &metadata);
-};
\ No newline at end of file
+    // 索引中不保存完整的 key，只保存一个足够区分相邻 block 的短 key：
+    // 返回满足 a <= s < b 的最短的 s，a 必须小于 b
+    static std::string shortest_separator(std::string_view a, std::string_view b);
+    // 返回不小于 a 的一个短 key，用于最后一个 block
+    static std::string shortest_successor(std::string_view a);
+};
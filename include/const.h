@@ -3,10 +3,29 @@
 #define LSM_TOTAL_MEM_SIZE_LIMIT (64 * 1024 * 1024) // 64MB
 #define LSM_PER_MEM_SIZE_LIMIT (1024 * 1024 * 1024) // 4MB
 
+#define LSM_MAX_IMMUTABLE_MEMTABLES 4 // 等待刷盘的冻结表数量上限，达到后停止写入
+#define LSM_WRITE_SLOWDOWN_US 1000    // 冻结表堆积时每次写入延迟的时间(微秒)
+
+#define LSM_ARENA_CHUNK_SIZE (256 * 1024) // 跳表arena每次申请的chunk大小
+#define LSM_SKIPLIST_LOOKUP_GROUP 8 // 跳表批量查找时同时推进的查找个数
+#define LSM_SKIPLIST_BLOOM_BYTES_PER_BIT 16 // 跳表的内存布隆过滤器按活跃表大小上限每 16 字节分配 1 位，64MB 对应 512KB
+#define LSM_SKIPLIST_BLOOM_MIN_BITS 4096    // 跳表布隆过滤器的最少位数
+
 #define LSM_BLOCK_MEM_LIMIT (32 * 1024) // 32KB
+#define LSM_BLOCK_RESTART_INTERVAL 16   // block 中每隔多少条记录保存一次完整的 key(重启点)
+#define LSM_BLOCK_HASH_INDEX true       // SST 的数据块是否附带点查用的哈希索引
+#define LSM_BLOCK_HASH_UTIL_RATIO 0.75  // 哈希索引中 key 的数量与桶数量之比
+
+#define LSM_SST_INDEX_PARTITION_SIZE (4 * 1024) // SST 索引超过该大小时拆成按需读取的索引分区
+
+#define LSM_VERIFY_CHECKSUMS true // 从文件读取 block 时默认校验 CRC32C
 
 #define LSM_BLOCK_CACHE_CAPACITY 1024
 #define LSM_BLOCK_CACHE_K 8
+#define LSM_TABLE_CACHE_CAPACITY 256 // 同时打开的 SST 数量上限，限制文件描述符和常驻内存的索引、布隆过滤器
+
+#define LSM_BUFFER_POOL_CAPACITY (32 * 1024 * 1024) // 缓冲区池中最多保留的空闲缓冲区总容量
+#define LSM_BUFFER_POOL_MAX_OBJECTS 4096 // 每种大小的对象最多保留的空闲内存块数
 
 #define BLOOM_FILTER_EXPEXTED_SIZE 65536
 #define BLOOM_FILTER_EXPEXTED_ERROR_RATE 0.1
@@ -23,4 +42,10 @@
 
 #define REDIS_LIST_SEPARATOR '#' // 链表元素的分隔符
 
-#define LSM_SST_LEVEL_RATIO 16
\ No newline at end of file
+#define LSM_SST_LEVEL_RATIO 16
+#define LSM_COMPRESSION_MIN_LEVEL 1 // 从这一层开始 SST 的数据块使用 LZ 压缩，更上层的热数据不压缩
+
+#define LSM_BLOB_VALUE_THRESHOLD 4096 // 不小于该长度的 value 写入 blob 文件，SST 中只保存引用
+#define LSM_BLOB_FILE_SIZE (64 * 1024 * 1024) // 单个 blob 文件写到该大小后换新文件
+#define LSM_BLOB_GC_RATIO 0.5 // blob 文件的存活数据占比低于该值时，compaction 把其中的 value 搬到新文件
+#define LSM_BLOB_VALUE_TAG '\xff' // SST 中以该字节开头的 value 是 blob 引用或转义过的普通 value
@@ -1,16 +1,23 @@
 #pragma once
 
 #include "../memtable/memtable.h"
+#include "../const.h"
 #include "../block/block_cache.h"
 #include "../sst/sst.h"
+#include "../sst/table_cache.h"
 #include "two_merge_iterator.h"
 #include "transaction.h"
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <condition_variable>
+#include <thread>
 #include <cstring>
 #include <unordered_map>
 #include <optional>
 #include <deque>
+#include <exception>
+#include <atomic>
 #include <map>
 
 class TranContext;
@@ -23,32 +30,67 @@ class LSMEngine
     Memtable memtable;
 
     std::map<size_t, std::deque<size_t>> level_sst_ids;                          // 有序列表，存储L0层的SSTable的ID
-    std::unordered_map<size_t, std::shared_ptr<SST>> ssts; // 哈希表，通过SSTbale的ID来获取SSTable。提供高效的随机访问能力。
 
     std::shared_ptr<BlockCache> block_cache;
+    std::shared_ptr<TableCache> table_cache; // 通过SSTable的ID获取SSTable，第一次访问时才打开文件
+    std::shared_ptr<BlobStore> blob_store; // 大 value 所在的 blob 文件
+    // 每个 SST 引用的 blob 文件及字节数，SST 生成时或第一次 GC 时记录，删除时移除，由 ssts_mtx 保护
+    std::unordered_map<size_t, std::unordered_map<size_t, uint64_t>> sst_blob_refs;
 
     std::shared_mutex ssts_mtx;
     size_t cur_max_level = 0;
     size_t next_sst_id = 0;
 
+    // 后台刷盘
+    // 写操作只负责冻结活跃表，由刷盘线程把冻结表依次写入 L0
+    size_t memtable_size_limit;     // 活跃表达到该大小时冻结
+    size_t max_immutable_memtables; // 冻结表数量达到该值时停止写入，直到刷盘线程追上
+    size_t slowdown_trigger;        // 冻结表数量达到该值时每次写入都会被延迟
+    std::thread flush_thread;
+    std::mutex flush_mtx;
+    std::condition_variable flush_cv;      // 唤醒刷盘线程
+    std::condition_variable flush_done_cv; // 刷盘完成后唤醒被阻塞的写操作
+    bool stop_flush = false;
+    // 刷盘或 compaction 抛出的异常，由 flush_mtx 保护，下一次写入时抛给调用方
+    std::exception_ptr bg_error;
+    std::atomic<bool> has_bg_error{false};
+
+    // 刷盘时用它取得最老的活跃事务，丢弃不会再被读到的旧版本，由 flush_mtx 保护
+    std::weak_ptr<TranManager> tran_manager;
+
 private:
     void flush();
     void flush_all();
+    void flush_worker();
+    void make_room_for_write(); // 写入前检查是否需要延迟写入，后台刷盘出错时抛出该错误
+    void maybe_freeze();        // 写入后检查活跃表是否需要冻结
     std::string get_sst_path(size_t sst_id);
 
     size_t get_sst_size(const size_t &level);
+    CompressionType get_compression(size_t level); // 该层 SST 的数据块使用的压缩算法
+    void collect_blob_garbage(); // 汇总 sst_blob_refs，删除不再被引用的 blob 文件，调用方需持有 ssts_mtx
 
 public:
-    LSMEngine(std::string path);
+    // rep_type 指定内存表使用的存储结构，memtable_size_limit 是活跃表冻结的大小
+    LSMEngine(std::string path, size_t max_immutable_memtables = LSM_MAX_IMMUTABLE_MEMTABLES,
+              MemTableRepType rep_type = MemTableRepType::SkipList,
+              size_t memtable_size_limit = LSM_TOTAL_MEM_SIZE_LIMIT);
     ~LSMEngine();
+    void set_tran_manager(std::shared_ptr<TranManager> manager);
     void put(const std::string &key, const std::string &value, uint64_t tranc_id);
     void put_batch(const std::vector<std::pair<std::string, std::string>> &kvs, uint64_t tranc_id);
-    std::optional<std::pair<std::string, uint64_t>> get(const std::string &key, uint64_t tranc_id);
-    std::optional<std::pair<std::string, uint64_t>> sst_get_(const std::string &key, uint64_t tranc_id);
+    // options 控制本次读取从文件加载数据块时是否校验，只影响这一次读操作
+    std::optional<std::pair<std::string, uint64_t>> get(const std::string &key, uint64_t tranc_id,
+                                                        const ReadOptions &options = ReadOptions());
+    std::optional<std::pair<std::string, uint64_t>> sst_get_(const std::string &key, uint64_t tranc_id,
+                                                             const ReadOptions &options = ReadOptions());
     void remove(const std::string &key, uint64_t tranc_id);
     void remove_batch(const std::vector<std::string> &keys, uint64_t tranc_id);
 
     void clear();
+    size_t open_sst_count(); // 当前打开的 SST 数量
+    size_t frozen_memtable_count(); // 等待刷盘的冻结表数量
+    size_t level_sst_count(size_t level); // 该层 SST 的数量
 
     void full_compact(size_t src_level);
 
@@ -64,7 +106,8 @@ public:
                                                          size_t target_sst_size,
                                                          size_t target_sst_level);
 
-    std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>> iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate);
+    std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>> iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate,
+                                                                                         const ReadOptions &options = ReadOptions());
 };
 
 class LSM
@@ -7,6 +7,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <vector>
 #include <unordered_map>
 #include <optional>
@@ -48,10 +49,15 @@ private:
     // 暂存未提交的写操作
     std::unordered_map<std::string, std::optional<std::string>> temp_map_;
 
+    bool finished_ = false; // 是否已经通知事务管理器不再跟踪该事务
+    void finish();          // 提交、回滚或析构时调用，只通知一次
+
 public:
     TranContext(uint64_t tranc_id, std::shared_ptr<LSMEngine> engine,
                 std::shared_ptr<TranManager> manager,
                 const enum IsolationLevel isolation_level);
+    // 没有提交或回滚就被丢弃的事务也要从活跃事务中移除，否则会一直阻止旧版本的回收
+    ~TranContext();
     void put(const std::string &key, const std::string &value);
     void remove(const std::string &key);
     std::optional<std::string> get(const std::string &key);
@@ -81,6 +87,12 @@ public:
     void update_max_flushed_tranc_id(uint64_t max_flushed_tranc_id_);
     void update_max_finished_tranc_id(uint64_t max_finished_tranc_id_);
 
+    // 事务提交或回滚后调用，不再跟踪该事务
+    void finish_tranc(uint64_t tranc_id);
+    // 仍在运行的事务中最小的事务 id，没有运行中的事务时返回下一个事务 id
+    // 事务 id 小于它的旧版本只要被更新的版本遮蔽，就不会再被任何事务读到
+    uint64_t get_oldest_active_tranc_id();
+
 private:
     std::string get_tranc_id_file_path();
     void read_tranc_id_file();
@@ -98,5 +110,6 @@ private:
     uint64_t next_tranc_id_ = 1;         // 下一个可用的事务ID
     uint64_t max_flushed_tranc_id_ = 0;  // 已刷盘的最大事务ID。事务是否已经持久化
     uint64_t max_finished_tranc_id_ = 0; // 已完成的最大事务ID。事务是否已经成功提交或回滚
+    std::set<uint64_t> active_trancs_;   // 正在运行的事务ID
     FileObj tranc_id_file_;              // 事务ID文件,用于持久化事务ID
 };
\ No newline at end of file
@@ -13,12 +13,16 @@ private:
     bool choose_a = false;
     mutable std::shared_ptr<value_type> current;
     uint64_t max_tranc_id_;
+    bool skip_delete_ = true; // 是否跳过删除标记，compaction 需要保留它们
 
     void update_current() const;
+    // 合并重复 key 后跳过删除标记，停在下一条可以输出的记录上
+    void seek_visible();
 
 public:
     TwoMergeIterator(uint64_t tranc_id);
-    TwoMergeIterator(std::shared_ptr<BaseIterator> a, std::shared_ptr<BaseIterator> b, uint64_t max_tranc_id);
+    TwoMergeIterator(std::shared_ptr<BaseIterator> a, std::shared_ptr<BaseIterator> b, uint64_t max_tranc_id,
+                     bool skip_delete = true);
 
     bool choose_it_a(); // 是否选择迭代器it_a
     void skip_it_b();
@@ -15,6 +15,7 @@ enum class IteratorType {
   TwoMergeIterator,
   ConcatIterator,
   LevelIterator,
+  MemMergeIterator,
 };
 
 class BaseIterator {
@@ -59,7 +60,8 @@ class HeapIterator : public BaseIterator {
 public:
   HeapIterator() = default;
   virtual ~HeapIterator() = default;
-  HeapIterator(std::vector<SearchItem> item_vec, uint64_t max_tranc_id);
+  // skip_delete 为 false 时保留删除标记，compaction 需要用它遮蔽更低层的旧版本
+  HeapIterator(std::vector<SearchItem> item_vec, uint64_t max_tranc_id, bool skip_delete = true);
   pointer operator->() const;
   virtual value_type operator*() const override;
   BaseIterator &operator++() override;
@@ -86,4 +88,5 @@ private:
       items;
   mutable std::shared_ptr<value_type> current; // 用于存储当前元素
   uint64_t max_tranc_id_ = 0;
+  bool skip_delete_ = true;
 };
\ No newline at end of file
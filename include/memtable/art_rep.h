@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../skiplist/skiplist.h"
+#include "memtable_rep.h"
+#include <mutex>
+#include <shared_mutex>
+
+// 基于自适应基数树(Adaptive Radix Tree)的 memtable
+// 内部节点按子节点数量在 4 / 16 / 48 / 256 四种大小之间增长，单个子节点的路径压缩为前缀
+// 查找只比较 key 的字节，不做完整的 key 比较；有大量公共前缀的 key 时比跳表更省比较次数
+// 叶子是该 key 的版本链表头(见 version_chain.h)，所有节点都在 arena 中分配
+class ArtRep : public MemTableRep
+{
+private:
+    std::shared_ptr<Arena> arena;
+    void *root = nullptr; // 内部节点或打了标记的叶子
+    size_t size_bytes = 0;
+    mutable std::shared_mutex mtx; // 保护整棵树、size_bytes 和版本链表
+
+    std::shared_ptr<const SkipListIterator::Snapshot> sorted; // 缓存的有序快照，插入新记录时失效
+    std::mutex sorted_mtx;
+
+    // 返回保存 key 叶子的槽位，路径不存在时创建，槽位可能为空
+    void **leaf_slot(std::string_view key);
+    SkipListNode *find_leaf(std::string_view key) const;
+
+    void put_(std::string_view key, std::string_view value, uint64_t tranc_id);
+    SkipListIterator get_(std::string_view key, uint64_t tranc_id) const;
+    std::shared_ptr<const SkipListIterator::Snapshot> get_sorted();
+
+public:
+    ArtRep();
+    ArtRep(const ArtRep &) = delete;
+    ArtRep &operator=(const ArtRep &) = delete;
+
+    void put(std::string_view key, std::string_view value, uint64_t tranc_id = 0) override;
+    void put_batch(std::vector<std::pair<std::string_view, std::string_view>> kvs, uint64_t tranc_id = 0) override;
+    SkipListIterator get(std::string_view key, uint64_t tranc_id = 0) override;
+    std::vector<SkipListIterator> get_batch(const std::vector<std::string_view> &keys, uint64_t tranc_id = 0) override;
+    void remove(std::string_view key) override;
+    void clear() override;
+
+    SkipListIterator begin() override;
+    SkipListIterator end() override;
+
+    std::optional<std::pair<SkipListIterator, SkipListIterator>> iters_monotony_predicate(std::function<int(const std::string &)> predicate) override;
+
+    size_t get_size() const override;
+    size_t get_memory_usage() const override;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../skiplist/skiplist.h"
+#include "memtable_rep.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+// 基于哈希表的 memtable
+// 点查和写入只需要一次哈希查找，不维护顺序；遍历和范围查询时才对所有记录排序，
+// 排序结果会缓存下来，直到下一次插入新记录
+// 适合点查为主、很少范围查询的负载
+class HashTableRep : public MemTableRep
+{
+private:
+    std::shared_ptr<Arena> arena;
+    // key 指向 arena 中第一个版本的 key，值是该 key 的版本链表头(见 version_chain.h)
+    std::unordered_map<std::string_view, SkipListNode *> table;
+    size_t size_bytes = 0;
+    mutable std::shared_mutex mtx; // 保护 table、size_bytes 和版本链表
+
+    std::shared_ptr<const SkipListIterator::Snapshot> sorted; // 缓存的有序快照，插入新记录时失效
+    std::mutex sorted_mtx;
+
+    void put_(std::string_view key, std::string_view value, uint64_t tranc_id);
+    SkipListIterator get_(std::string_view key, uint64_t tranc_id) const;
+    std::shared_ptr<const SkipListIterator::Snapshot> get_sorted();
+
+public:
+    HashTableRep();
+    HashTableRep(const HashTableRep &) = delete;
+    HashTableRep &operator=(const HashTableRep &) = delete;
+
+    void put(std::string_view key, std::string_view value, uint64_t tranc_id = 0) override;
+    void put_batch(std::vector<std::pair<std::string_view, std::string_view>> kvs, uint64_t tranc_id = 0) override;
+    SkipListIterator get(std::string_view key, uint64_t tranc_id = 0) override;
+    std::vector<SkipListIterator> get_batch(const std::vector<std::string_view> &keys, uint64_t tranc_id = 0) override;
+    void remove(std::string_view key) override;
+    void clear() override;
+
+    SkipListIterator begin() override;
+    SkipListIterator end() override;
+
+    std::optional<std::pair<SkipListIterator, SkipListIterator>> iters_monotony_predicate(std::function<int(const std::string &)> predicate) override;
+
+    size_t get_size() const override;
+    size_t get_memory_usage() const override;
+};
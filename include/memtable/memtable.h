@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../skiplist/skiplist.h"
+#include "memtable_iterator.h"
+#include "memtable_rep.h"
 #include "../../include/iterator/iterator.h"
 #include "../sst/sst.h"
 #include <list>
@@ -12,8 +14,10 @@ class Memtable
     friend class TranContext;
 
 private:
-    std::shared_ptr<SkipList> current_table;
-    std::list<std::shared_ptr<SkipList>> frozen_tables;
+    MemTableRepType rep_type; // 活跃表和冻结表使用的存储结构
+    size_t size_limit;        // 活跃表冻结的大小，用来确定新表中布隆过滤器的大小
+    std::shared_ptr<MemTableRep> current_table;
+    std::list<std::shared_ptr<MemTableRep>> frozen_tables;
     size_t frozen_bytes;
 
     // std::shared_mutex rx_mutex; // 读写锁，以skiplist为单位
@@ -21,7 +25,7 @@ private:
     std::shared_mutex cur_mtx;    // 读写current_table的锁
     std::shared_mutex frozen_mtx; // 读写frozen_tables的锁
 public:
-    Memtable();
+    Memtable(MemTableRepType rep_type = MemTableRepType::SkipList, size_t size_limit = LSM_TOTAL_MEM_SIZE_LIMIT);
     ~Memtable() = default;
     void put(const std::string &key, const std::string &value, uint64_t tranc_id);
     void put_batch(const std::vector<std::pair<std::string, std::string>> &kvs, uint64_t tranc_id);
@@ -30,11 +34,13 @@ public:
     void clear();
 
     // 迭代器
-    HeapIterator begin(uint64_t tranc_id);
-    HeapIterator end(uint64_t tranc_id);
+    MemMergeIterator begin(uint64_t tranc_id);
+    MemMergeIterator end(uint64_t tranc_id);
 
     // 谓词查询
-    std::optional<std::pair<HeapIterator, HeapIterator>> iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate);
+    // skip_delete 为 false 时结果中保留删除标记
+    std::optional<std::pair<MemMergeIterator, MemMergeIterator>> iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate,
+                                                                                         bool skip_delete = true);
 
     SkipListIterator get(const std::string &key, uint64_t tranc_id);
     SkipListIterator get_(const std::string &key, uint64_t tranc_id);
@@ -43,9 +49,18 @@ public:
     size_t get_cur_size();
     size_t get_frozen_size();
     size_t get_total_size();
+    size_t get_frozen_count(); // 冻结表的数量
 
     // 构建SST
-    std::shared_ptr<SST> flush_last(SSTBuilder &builder, std::string &sst_path, size_t sst_id, std::shared_ptr<BlockCache> block_cache);
+    // 将当前所有的冻结表归并写入一个SST，flushed_count 返回写入的冻结表数量(没有冻结表时先冻结活跃表)
+    // 冻结表不会被移除，调用方在 SST 对读可见之后再调用 pop_last(flushed_count)
+    // 这样刷盘期间的读操作总能在内存表或 SST 中找到数据
+    // 多张表中相同的 (key, 事务 id) 只写入最新的表中的一条
+    // gc_tranc_id 是仍可能读取旧版本的最小事务 id：每个 key 只保留事务 id 大于它的版本，
+    // 以及不大于它的最新一个版本，更旧的版本对任何事务都不可见，不写入 SST。为 0 时保留所有版本
+    std::shared_ptr<SST> flush_frozen(SSTBuilder &builder, std::string &sst_path, size_t sst_id, std::shared_ptr<BlockCache> block_cache,
+                                      uint64_t gc_tranc_id, size_t &flushed_count);
+    void pop_last(size_t count = 1); // 移除最旧的 count 张冻结表
 
     void frozen_cur_table();
 
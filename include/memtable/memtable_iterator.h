@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../iterator/iterator.h"
+#include "../skiplist/skiplist.h"
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// 合并多个跳表的迭代器
+// 直接在各个跳表上推进 SkipListIterator，按需取出下一个 key，不会预先拷贝数据
+// 每个 SkipListIterator 都持有所在跳表的 arena，迭代期间跳表即使被刷盘释放，节点仍然有效
+class MemMergeIterator : public BaseIterator
+{
+public:
+    MemMergeIterator() = default;
+    // ranges 中每一项是一个跳表上的 [begin, end) 区间，需要按照跳表从新到旧排列
+    // 同一个 key 优先使用事务 id 更大的记录，事务 id 相同时以较新的跳表为准
+    // skip_delete 为 false 时保留删除标记，供上层和更旧的数据合并时屏蔽旧记录
+    MemMergeIterator(std::vector<std::pair<SkipListIterator, SkipListIterator>> ranges, uint64_t max_tranc_id,
+                     bool skip_delete = true);
+    virtual ~MemMergeIterator() = default;
+
+    pointer operator->() const;
+    virtual value_type operator*() const override;
+    virtual BaseIterator &operator++() override;
+    virtual bool operator==(const BaseIterator &other) const override;
+    virtual bool operator!=(const BaseIterator &other) const override;
+
+    virtual IteratorType get_type() const override;
+    virtual uint64_t get_tranc_id() const override; // 当前记录的事务 id
+    virtual bool is_end() const override;
+    virtual bool is_valid() const override;
+
+    std::string_view get_key_view() const { return cur_key; }
+    std::string_view get_value_view() const { return cur_value; }
+
+private:
+    struct Cursor
+    {
+        SkipListIterator iter;
+        SkipListIterator end;
+        size_t idx; // 跳表的新旧顺序，越小越新
+    };
+
+    static bool cursor_greater(const Cursor &a, const Cursor &b);
+    // 堆顶的游标向后移动一步，到达区间末尾时移出堆
+    void advance_top();
+    // 从堆顶开始找到下一个可见且没有被删除的 key
+    void seek_visible();
+    void update_current() const;
+
+private:
+    std::vector<Cursor> cursors;
+    std::vector<size_t> heap; // 以 cursors 的下标组成的小顶堆
+
+    bool valid = false;
+    std::string_view cur_key;
+    std::string_view cur_value;
+    uint64_t cur_tranc_id = 0;
+    uint64_t max_tranc_id_ = 0;
+    bool skip_delete_ = true;
+
+    mutable std::shared_ptr<value_type> current; // 用于 operator->
+};
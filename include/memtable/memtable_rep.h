@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../const.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// memtable 中单张表的存储结构
+// Memtable 的活跃表和冻结表都通过这个接口访问，可以在 SkipList、哈希表、ART 之间切换
+// 所有实现都把记录保存为 arena 中的 SkipListNode，查询和遍历统一返回 SkipListIterator
+//
+// 实现需要支持多个线程同时调用 put / put_batch / get，clear 需要调用方保证没有并发访问
+
+class SkipListIterator;
+
+enum class MemTableRepType
+{
+    SkipList,  // 跳表，有序，支持无锁并发写入
+    HashTable, // 哈希表，点查 O(1)，遍历时才排序
+    Art,       // 自适应基数树，有序，适合带有长公共前缀的 key
+};
+
+class MemTableRep
+{
+public:
+    virtual ~MemTableRep() = default;
+
+    virtual void put(std::string_view key, std::string_view value, uint64_t tranc_id = 0) = 0;
+    // 同一批中相同的 key 以后出现的为准
+    virtual void put_batch(std::vector<std::pair<std::string_view, std::string_view>> kvs, uint64_t tranc_id = 0) = 0;
+    // 返回事务 id 不大于 tranc_id 的最新记录，tranc_id 为 0 时返回最新的记录
+    virtual SkipListIterator get(std::string_view key, uint64_t tranc_id = 0) = 0;
+    virtual std::vector<SkipListIterator> get_batch(const std::vector<std::string_view> &keys, uint64_t tranc_id = 0) = 0;
+    virtual void remove(std::string_view key) = 0; // 逻辑删除 key 最新的版本
+    virtual void clear() = 0;
+
+    // 按 (key 升序, 事务 id 降序) 遍历所有记录
+    virtual SkipListIterator begin() = 0;
+    virtual SkipListIterator end() = 0;
+
+    // 返回满足单调谓词的记录区间 [begin, end)，语义与 SkipList::iters_monotony_predicate 相同
+    virtual std::optional<std::pair<SkipListIterator, SkipListIterator>> iters_monotony_predicate(std::function<int(const std::string &)> predicate) = 0;
+
+    virtual size_t get_size() const = 0;
+    virtual size_t get_memory_usage() const = 0;
+
+    // 返回 false 时 key 一定不在表中
+    virtual bool may_contain(std::string_view /*key*/) const { return true; }
+};
+
+// 创建一张指定类型的空表，size_limit 是这张表预计写入的数据量
+std::shared_ptr<MemTableRep> new_memtable_rep(MemTableRepType type, size_t size_limit = LSM_TOTAL_MEM_SIZE_LIMIT);
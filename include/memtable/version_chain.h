@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../skiplist/skiplist.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+// 哈希表、ART 等非跳表的 memtable 实现中，同一个 key 的所有版本
+// 按事务 id 从大到小通过 forward[0] 串成一条链表，索引结构只保存链表头
+// 链表只在持有表的写锁时修改
+
+// 写入 (key, tranc_id)，返回表大小的变化量，inserted 表示是否新增了节点
+// 链表头可能被替换为新节点
+inline int64_t chain_put(SkipListNode *&head, Arena &arena, std::string_view key, std::string_view value, uint64_t tranc_id, bool &inserted)
+{
+    inserted = false;
+    SkipListNode *prev = nullptr;
+    SkipListNode *current = head;
+    while (current && current->tranc_id > tranc_id)
+    {
+        prev = current;
+        current = current->next(0);
+    }
+
+    if (current && current->tranc_id == tranc_id)
+    {
+        // 版本已经存在，只替换 value
+        const char *old_slot = current->value_slot.exchange(SkipListNode::new_value_slot(arena, value), std::memory_order_acq_rel);
+        if (current->deleted.exchange(false, std::memory_order_acq_rel))
+        {
+            return key.size() + value.size() + sizeof(uint64_t);
+        }
+        uint32_t old_len;
+        memcpy(&old_len, old_slot, sizeof(uint32_t));
+        return static_cast<int64_t>(value.size()) - old_len;
+    }
+
+    SkipListNode *node = SkipListNode::create(arena, key, value, 1, tranc_id);
+    inserted = true;
+    node->set_next(0, current);
+    if (prev)
+    {
+        prev->set_next(0, node);
+    }
+    else
+    {
+        head = node;
+    }
+    return key.size() + value.size() + sizeof(uint64_t);
+}
+
+// 事务 id 不大于 tranc_id 的最新未删除版本，tranc_id 为 0 时返回最新的版本
+inline SkipListNode *chain_get(SkipListNode *head, uint64_t tranc_id)
+{
+    uint64_t search_id = tranc_id == 0 ? UINT64_MAX : tranc_id;
+    SkipListNode *current = head;
+    while (current && (current->tranc_id > search_id || current->is_deleted()))
+    {
+        current = current->next(0);
+    }
+    return current;
+}
+
+// 逻辑删除最新的未删除版本，返回表大小减少的字节数
+inline size_t chain_remove(SkipListNode *head)
+{
+    SkipListNode *current = chain_get(head, 0);
+    if (current && !current->deleted.exchange(true, std::memory_order_acq_rel))
+    {
+        return current->key_len + current->value().size() + sizeof(uint64_t);
+    }
+    return 0;
+}
+
+// 把整条链表按事务 id 从大到小追加到 snapshot
+inline void chain_collect(const SkipListNode *head, std::vector<const SkipListNode *> &snapshot)
+{
+    for (const SkipListNode *current = head; current; current = current->next(0))
+    {
+        snapshot.push_back(current);
+    }
+}
+
+// 在有序快照上二分查找满足单调谓词的区间，语义与 SkipList::iters_monotony_predicate 相同
+inline std::optional<std::pair<SkipListIterator, SkipListIterator>> snapshot_predicate_range(
+    std::shared_ptr<const SkipListIterator::Snapshot> snapshot, std::shared_ptr<Arena> arena,
+    const std::function<int(const std::string &)> &predicate)
+{
+    // 区间左侧的 key 返回 >0，区间内返回 0，区间右侧返回 <0
+    auto first = std::partition_point(snapshot->begin(), snapshot->end(), [&](const SkipListNode *node)
+                                      { return predicate(std::string(node->key())) > 0; });
+    auto last = std::partition_point(first, snapshot->end(), [&](const SkipListNode *node)
+                                     { return predicate(std::string(node->key())) >= 0; });
+
+    // 迭代器会跳过被逻辑删除的记录，区间内的记录可能全部被删除
+    SkipListIterator begin_iter(snapshot, first - snapshot->begin(), arena);
+    SkipListIterator end_iter(snapshot, last - snapshot->begin(), arena);
+    if (!begin_iter.is_valid() || predicate(begin_iter.get_key()) != 0)
+    {
+        return std::nullopt;
+    }
+    return std::make_optional(std::make_pair(begin_iter, end_iter));
+}
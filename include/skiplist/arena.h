@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 跳表使用的内存池
+// 以大块(chunk)为单位向系统申请内存，节点、key、value 在 chunk 中连续分配
+// 不支持单独释放，arena 析构时一次性归还所有 chunk
+//
+// 支持多线程并发分配：在当前 chunk 内通过原子地推进偏移量分配，
+// 只有当前 chunk 用完、需要申请新 chunk 时才会加锁
+class Arena
+{
+private:
+    struct Chunk
+    {
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+        std::atomic<size_t> used; // 已分配的字节数，分配失败时可能超过 capacity
+
+        Chunk(size_t capacity, size_t used) : data(new char[capacity]), capacity(capacity), used(used) {}
+    };
+
+    std::atomic<Chunk *> current;              // 当前用于分配的 chunk
+    std::vector<std::unique_ptr<Chunk>> chunks; // 所有 chunk，由 mtx 保护
+    std::atomic<size_t> memory_usage;          // 已向系统申请的总字节数
+    std::mutex mtx;
+
+    Chunk *new_chunk(size_t capacity, size_t used);
+
+public:
+    Arena();
+    ~Arena() = default;
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // 分配 bytes 字节，返回的地址按 8 字节对齐，可被多个线程同时调用
+    char *allocate(size_t bytes);
+
+    size_t get_memory_usage() const;
+};
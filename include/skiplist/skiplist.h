@@ -1,108 +1,151 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <atomic>
+#include <cstring>
 #include <optional>
 #include <shared_mutex>
 #include <cstdlib>
 #include <random>
 #include <functional>
+#include "../const.h"
 #include "../iterator/iterator.h"
+#include "../memtable/memtable_rep.h"
+#include "arena.h"
 
 // 跳表的节点
 // 允许多个key连续出现，通过tranc_id进行进一步的区分
+// 节点、key、value 以及各层的 next 指针都在所属跳表的 arena 中连续分配：
+// | SkipListNode | forward[1..level) | key | value_len | value |
+// 节点头部内联保存 key 的前 8 个字节(key_prefix)，大部分比较只需要读节点本身
+//
+// 节点一旦链入跳表就不会被摘除，next 指针和 value 都通过原子变量发布，
+// 因此读线程无需加锁即可与写线程并发访问
+//
+// 哈希表、ART 等其他 memtable 实现也使用这个节点保存记录(只有 1 层)，以便共用 SkipListIterator
 struct SkipListNode
 {
-    std::string key;   // 节点存储的键
-    std::string value; // 节点存储的值
+    uint64_t key_prefix;  // key 的前 8 个字节按大端序组成的整数，不足补 0，大小关系与字典序一致
+    const char *key_data; // 指向 arena 中的 key
+    uint32_t key_len;
+    int level;         // 节点的层数
     uint64_t tranc_id; // 事务ID
 
-    std::vector<std::shared_ptr<SkipListNode>>
-        forward; // 指向不同层级的下一个节点的指针数组，shared_ptr是为了在多层级中保持对下一个节点的强引用，确保节点在有引用时不会被销毁。
-    std::vector<std::weak_ptr<SkipListNode>>
-        backward; // 指向不同层级的下一个节点的指针数组，weak_ptr 是为了避免双向链表中出现循环引用导致内存泄漏，同时允许反向遍历时获取节点。
-    SkipListNode(const std::string &k, const std::string &v, int level, uint64_t tranc_id)
-        : key(k), value(v), forward(level, nullptr),
-          backward(level, std::weak_ptr<SkipListNode>()), tranc_id(tranc_id) {}
-    void set_backward(int level, std::shared_ptr<SkipListNode> node)
-    {
-        backward[level] = std::weak_ptr<SkipListNode>(node);
-    }
+    std::atomic<const char *> value_slot; // 指向 arena 中的 | value_len(uint32_t) | value |，更新 value 时整体替换
+    std::atomic<bool> deleted;            // 逻辑删除标记
 
-    bool operator<(const SkipListNode &other) const
-    {
-        if (key == other.key)
-        {
-            // key相同时，事务id更大的优先级更高
-            return tranc_id > other.tranc_id;
-        }
-        return key < other.key;
-    }
+    // 指向不同层级的下一个节点，实际长度为 level，随节点一起在 arena 中分配
+    std::atomic<SkipListNode *> forward[1];
 
-    bool operator>(const SkipListNode &other) const
+    std::string_view key() const { return std::string_view(key_data, key_len); }
+    std::string_view value() const
     {
-        if (key == other.key)
-        {
-            // key相同时，事务id更大的优先级更高
-            return tranc_id < other.tranc_id;
-        }
-        return key > other.key;
+        const char *slot = value_slot.load(std::memory_order_acquire);
+        uint32_t value_len;
+        memcpy(&value_len, slot, sizeof(uint32_t));
+        return std::string_view(slot + sizeof(uint32_t), value_len);
     }
+    bool is_deleted() const { return deleted.load(std::memory_order_acquire); }
 
-    bool operator==(const SkipListNode &other) const
+    SkipListNode *next(int i) const { return forward[i].load(std::memory_order_acquire); }
+    void set_next(int i, SkipListNode *node) { forward[i].store(node, std::memory_order_release); }
+    // 只有当第 i 层的后继仍是 expected 时才链入 node
+    bool cas_next(int i, SkipListNode *expected, SkipListNode *node)
     {
-        return key == other.key && tranc_id == other.tranc_id && value == other.value;
+        return forward[i].compare_exchange_strong(expected, node, std::memory_order_acq_rel);
     }
 
-    bool operator!=(const SkipListNode &other) const
-    {
-        return !(*this == other);
-    }
+    // 在 arena 中分配一个 level 层的节点，key 和 value 紧跟在节点之后
+    static SkipListNode *create(Arena &arena, std::string_view key, std::string_view value, int level, uint64_t tranc_id);
+    // 在 arena 中分配一个新的 value，用于替换已有节点的 value
+    static const char *new_value_slot(Arena &arena, std::string_view value);
 };
 
 class SkipListIterator;
-class SkipList
+class SkipList : public MemTableRep
 {
 private:
-    std::shared_ptr<SkipListNode> head; // 跳表的头节点
-    int max_level;                      // 跳表的最大层数
-    int current_level;                  // 当前跳表的层数
-    size_t size_bytes = 0;
+    static constexpr int MAX_LEVEL_LIMIT = 32; // 层数上限，查找时前驱数组在栈上分配
 
-    std::random_device rd;
-    std::uniform_int_distribution<> dis_01;
-    std::uniform_int_distribution<> dis_level;
-    std::mt19937 gen;
+    std::shared_ptr<Arena> arena;   // 节点内存池，迭代器会共享持有，保证迭代期间节点有效
+    SkipListNode *head;             // 跳表的头节点
+    int max_level;                  // 跳表的最大层数
+    std::atomic<int> current_level; // 当前跳表的层数
+    std::atomic<size_t> size_bytes{0};
+
+    // 内存布隆过滤器，put 时记录 key，点查前先判断 key 是否可能存在
+    // 每个 key 只映射到一个 64 位的字中，插入只需要一次原子的 fetch_or
+    std::unique_ptr<std::atomic<uint64_t>[]> bloom_words;
+    size_t bloom_mask; // 字的数量减一，数量是2的幂
 
     int random_level(); // 随机生成节点的层数
+    void bloom_add(std::string_view key);
+
+    SkipListNode *new_node(std::string_view key, std::string_view value, int level, uint64_t tranc_id);
+    // 查找第一个不小于 (key, tranc_id) 的节点，prev 非空时记录每一层的前驱节点
+    SkipListNode *find_greater_or_equal(std::string_view key, uint64_t tranc_id, SkipListNode **prev) const;
+    // 从 prev 开始在第 level 层向后查找 (key, tranc_id) 的插入位置
+    void find_splice_for_level(std::string_view key, uint64_t tranc_id, int level, SkipListNode **prev, SkipListNode **next) const;
+    // get / get_batch 共用：从第一个不小于 (key, tranc_id) 的节点得到查询结果
+    SkipListIterator resolve_get(const SkipListNode *node, std::string_view key) const;
+    // prev 中是每一层插入位置之前的节点(不要求紧邻)，在 [0, 节点层数) 的每一层上链入新节点
+    // (key, tranc_id) 已经存在时只更新 value
+    void insert_with_splice(std::string_view key, std::string_view value, uint64_t tranc_id, SkipListNode **prev);
 
 public:
-    SkipList(int max_level = 16); // 默认的最大层数为16
-    void put(const std::string &key, const std::string &value, uint64_t tranc_id = 0);
-    SkipListIterator get(const std::string &key, uint64_t tranc_id = 0);
-    void remove(const std::string &key);
-    void clear();
+    // 跳表支持多个写线程并发 put，读线程(get / 迭代器)完全不加锁
+    // 插入时先在第0层通过 CAS 链入节点，再逐层向上链入
+    // 默认的最大层数为16，size_limit 是预计写入的数据量，用来确定布隆过滤器的大小
+    SkipList(int max_level = 16, size_t size_limit = LSM_TOTAL_MEM_SIZE_LIMIT);
+    SkipList(const SkipList &) = delete;
+    SkipList &operator=(const SkipList &) = delete;
+
+    void put(std::string_view key, std::string_view value, uint64_t tranc_id = 0) override;
+    // 批量写入：先按 key 排序，再复用上一次插入的前驱向后查找(finger search)
+    // 有序的批量写入不需要每次都从头节点开始查找
+    void put_batch(std::vector<std::pair<std::string_view, std::string_view>> kvs, uint64_t tranc_id = 0) override;
+    SkipListIterator get(std::string_view key, uint64_t tranc_id = 0) override;
+    // 批量查找：每组多个 key 的查找交替推进，每一步预取下一次要访问的节点，隐藏访存延迟
+    std::vector<SkipListIterator> get_batch(const std::vector<std::string_view> &keys, uint64_t tranc_id = 0) override;
+    void remove(std::string_view key) override; // 逻辑删除 key 最新的版本
+    void clear() override;                      // 需要调用方保证没有并发的写操作
 
     // begin() 和 end() 迭代器
-    SkipListIterator begin();
-    SkipListIterator end();
+    SkipListIterator begin() override;
+    SkipListIterator end() override;
 
     // 基于传入的谓词返回一对迭代器，表示满足该谓词条件的范围
     // 允许用户自定义筛选逻辑，增强了 SkipList 的灵活性和通用性
-    std::optional<std::pair<SkipListIterator, SkipListIterator>> iters_monotony_predicate(std::function<int(const std::string &)> predicate);
+    std::optional<std::pair<SkipListIterator, SkipListIterator>> iters_monotony_predicate(std::function<int(const std::string &)> predicate) override;
 
-    size_t get_size() const;
+    size_t get_size() const override;
+    size_t get_memory_usage() const override; // arena 实际占用的内存
 
-    std::vector<std::tuple<std::string, std::string, uint64_t>> flush(); // 获取键值对
+    // 返回 false 时 key 一定不在跳表中，返回 true 时可能存在
+    bool may_contain(std::string_view key) const override;
 };
 
+// 遍历 memtable 记录的迭代器，所有 MemTableRep 实现共用
+// 跳表直接沿第0层的 next 指针移动；其他实现先生成有序的节点快照，迭代器在快照上移动
 class SkipListIterator : public BaseIterator
 {
+public:
+    using Snapshot = std::vector<const SkipListNode *>;
+
 private:
-    std::shared_ptr<SkipListNode> current;
+    const SkipListNode *current;
+    std::shared_ptr<Arena> arena; // 持有节点所在的 arena，防止跳表被释放后访问失效内存
+    std::shared_ptr<const Snapshot> snapshot; // 非空时按快照的顺序遍历
+    size_t pos = 0;                           // current 在快照中的位置
 
 public:
-    SkipListIterator(std::shared_ptr<SkipListNode> node) : current(node) {};
+    SkipListIterator(const SkipListNode *node, std::shared_ptr<Arena> arena = nullptr)
+        : current(node), arena(std::move(arena)) {};
+    // 指向快照中的第 pos 个节点，pos 等于快照长度时为结束位置
+    SkipListIterator(std::shared_ptr<const Snapshot> snapshot, size_t pos, std::shared_ptr<Arena> arena);
+
     virtual ~SkipListIterator(); // 声明虚析构函数
 
     BaseIterator &operator++() override; // 前置自增
@@ -115,8 +158,11 @@ public:
 
     std::string get_key() const;
     std::string get_value() const;
+    // 直接指向 arena 中的数据，迭代器(或其拷贝)存活期间有效
+    std::string_view get_key_view() const { return current->key(); }
+    std::string_view get_value_view() const { return current->value(); }
 
     bool is_valid() const override;
     bool is_end() const override;
     uint64_t get_tranc_id() const override;
-};
\ No newline at end of file
+};
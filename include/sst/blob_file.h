@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../const.h"
+#include "../utils/file.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// 大 value 在 blob 文件中的位置
+struct BlobIndex
+{
+    size_t file_id;
+    uint64_t offset;
+    uint64_t size; // value 的长度，不含校验值
+};
+
+// value 在 SST 中的存储形式
+// 大部分 value(包括表示删除的空 value)原样存储，只有以 LSM_BLOB_VALUE_TAG 开头的需要区分：
+// | TAG | 0x00 | value |                                        普通 value 本身以 TAG 开头，转义后存储
+// | TAG | 0x01 | file_id varint | offset varint | size varint |  blob 引用
+// 读出的 value 必须经过 BlobValue 解析后才能返回给用户，compaction 则原样搬运
+class BlobValue
+{
+public:
+    static bool need_escape(std::string_view value);
+    static std::string encode_inline(std::string_view value);
+    static std::string encode_index(const BlobIndex &index);
+
+    // 是 blob 引用时解析到 index 并返回 true
+    static bool decode_index(std::string_view stored, BlobIndex &index);
+    // 去掉普通 value 的转义，stored 不能是 blob 引用
+    static std::string_view decode_inline(std::string_view stored);
+};
+
+// 只追加写入的 blob 文件，每条记录的格式：| value | CRC32C(uint32_t) |
+// 写入由刷盘线程完成，读取来自用户线程，文件句柄的访问用锁保护
+class BlobFile
+{
+private:
+    FileObj file;
+    size_t file_id;
+    size_t file_size = 0;
+    std::mutex mtx;
+
+public:
+    static std::shared_ptr<BlobFile> create(size_t file_id, const std::string &path);
+    static std::shared_ptr<BlobFile> open(size_t file_id, const std::string &path);
+
+    // 追加一个 value，返回它在文件中的位置
+    BlobIndex append(std::string_view value);
+    // 读取 index 指向的 value，校验失败时抛出 std::runtime_error
+    std::string read(const BlobIndex &index);
+
+    size_t get_file_id() const;
+    size_t size();
+    void del_file();
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../const.h"
+#include "blob_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 数据目录下所有 blob 文件的集合(键值分离)
+// 大 value 追加写入当前的 blob 文件，SST 中只保存 BlobIndex，compaction 只需要重写 key 和小 value
+// blob 文件本身不记录哪些数据还有效，每个 SST 记录它引用了各个 blob 文件多少字节，
+// 所有 SST 的引用相加就是每个 blob 文件的存活字节数：
+// 没有存活数据的文件直接删除，存活比例过低的文件在 compaction 时把仍被引用的 value 搬到新文件
+class BlobStore
+{
+private:
+    std::string data_dir;
+    size_t max_file_size; // 当前文件写到该大小后换新文件
+    std::mutex mtx;
+    std::unordered_map<size_t, std::shared_ptr<BlobFile>> files;
+    std::unordered_map<size_t, uint64_t> live_bytes; // 上一次 collect_garbage 时统计的存活字节数
+    std::shared_ptr<BlobFile> active;                // 正在写入的文件，延迟到第一次写入时创建
+    size_t next_file_id = 0;
+
+    std::string get_blob_path(size_t file_id);
+    std::shared_ptr<BlobFile> get_file(size_t file_id);
+
+public:
+    // 加载 data_dir 下已有的 blob 文件，新的 value 总是写入新文件
+    BlobStore(std::string data_dir, size_t max_file_size = LSM_BLOB_FILE_SIZE);
+
+    BlobIndex add(std::string_view value);
+    std::string get(const BlobIndex &index);
+
+    // 把 SST 中存储的 value 还原成用户写入的 value
+    std::string resolve(std::string_view stored);
+
+    // 该文件的存活比例低于 LSM_BLOB_GC_RATIO，compaction 遇到指向它的引用时应当重写 value
+    bool need_relocate(size_t file_id);
+
+    // live 是所有 SST 对每个 blob 文件的引用字节数，删除不再被引用的文件(正在写入的文件除外)
+    void collect_garbage(const std::unordered_map<size_t, uint64_t> &live);
+
+    size_t file_count();
+};
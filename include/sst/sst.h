@@ -1,20 +1,27 @@
 #pragma once
+#include "../const.h"
 #include "../block/block.h"
 #include "../block/blockmeta.h"
 #include "../block/block_cache.h"
 #include "../utils/file.h"
 #include "../utils/bloom_filter.h"
+#include "../utils/buffer_pool.h"
+#include "../utils/compression.h"
+#include "../utils/crc32c.h"
 #include "sst_iterator.h"
+#include "blob_store.h"
 #include <memory>
+#include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 class SSTBuilder;
 class SstIterator;
 class SST : public std::enable_shared_from_this<SST>
 {
-    friend std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(std::shared_ptr<SST> sst,
-                                                                                           uint64_t max_tranc_id, std::function<int(const std::string &)> predicate);
+    friend std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(uint64_t max_tranc_id, std::shared_ptr<SST> sst, std::function<int(const std::string &)> predicate, const ReadOptions &options);
     friend class SSTBuilder;
 
 private:
@@ -30,21 +37,45 @@ private:
     std::shared_ptr<BlockCache> cache;
     uint64_t min_tranc_id_ = UINT64_MAX;
     uint64_t max_tranc_id_ = 0;
+    std::unordered_map<size_t, uint64_t> blob_refs; // 引用的每个 blob 文件中 value 的总字节数
+
+    // 索引常驻内存的只有顶层索引块：
+    // 单层索引时每条记录是一个数据块的分隔 key 和 BlockMeta；
+    // 分区索引时每条记录是一个索引分区的最后一个分隔 key 和它的 BlockMeta，分区通过 block cache 按需读取
+    size_t num_data_blocks = 0;
+    std::shared_ptr<Block> index_block;
+    std::vector<BlockMeta> partition_metas;      // 每个索引分区的位置，单层索引时为空
+    std::vector<uint32_t> partition_first_block; // 每个索引分区中第一个数据块的编号
+
+    BlockMeta get_block_meta(size_t block_idx);
+    std::shared_ptr<Block> read_index_partition(size_t partition_idx);
+    std::shared_ptr<Block> load_block(const BlockMeta &meta, bool verify_checksum);
+    void set_index(std::shared_ptr<Block> top_index, size_t num_partitions); // 解析顶层索引中的分区信息
+
+    // 去掉从文件读出的 block 尾部的压缩类型和校验值，压缩过的 block 会被解压
+    static std::vector<uint8_t> unpack_block(std::vector<uint8_t> raw, bool verify_checksum);
 
 public:
-    std::vector<BlockMeta> meta_entries;
 
     static std::shared_ptr<SST> open(size_t sst_id, FileObj file, std::shared_ptr<BlockCache> cache);
+    // 只读取文件末尾的 footer 和 blob 引用统计，不解析索引和布隆过滤器
+    static std::unordered_map<size_t, uint64_t> read_blob_refs(FileObj &file);
+    // 只在从文件读取时校验，命中缓存时不再校验；不指定时按 LSM_VERIFY_CHECKSUMS 校验
     std::shared_ptr<Block> read_block(size_t block_id);
+    std::shared_ptr<Block> read_block(size_t block_id, bool verify_checksum);
 
-    SstIterator get(const std::string &key, uint64_t tranc_id);
+    SstIterator get(const std::string &key, uint64_t tranc_id, const ReadOptions &options = ReadOptions());
 
     size_t num_blocks();
 
-    SstIterator begin(uint64_t tranc_id);
+    SstIterator begin(uint64_t tranc_id, const ReadOptions &options = ReadOptions());
     SstIterator end(uint64_t tranc_id);
 
     size_t find_block_idx(const std::string &key); // 返回-1表示没找到
+    // 第一个分隔 key 不满足 before 的数据块，before 在 key 上单调(先 true 后 false)，都满足时返回 num_blocks()
+    // 分隔 key 满足 last_key(i) <= sep(i) < first_key(i + 1)，只读取索引，不读取数据块
+    size_t find_block_partition_point(const std::function<bool(std::string_view)> &before);
+    size_t index_memory_size() const;               // 常驻内存的索引大小(编码后的字节数)
 
     std::string get_first_key();
     std::string get_last_key();
@@ -52,6 +83,7 @@ public:
     size_t get_sst_id() const;
 
     std::pair<uint64_t, uint64_t> get_tranc_id_range() const;
+    const std::unordered_map<size_t, uint64_t> &get_blob_refs() const;
 
     void del_sst();
 };
@@ -60,18 +92,50 @@ class SSTBuilder
 {
 private:
     Block block; // 当前正在构建的block
-    std::string first_key;
+    std::string first_key; // 整个 SST 的第一个 key
     std::string last_key;
-    std::vector<BlockMeta> meta_entries;
     std::vector<uint8_t> data; // 已经编码的数据
     size_t block_size;         // block的容量，超出这个限制就被编码
     uint64_t min_tranc_id_ = UINT64_MAX;
     uint64_t max_tranc_id_ = 0;
+    CompressionType compression; // 数据块的压缩算法
+    std::shared_ptr<BlobStore> blob_store; // 为空时不做键值分离
+    std::unordered_map<size_t, uint64_t> blob_refs;
+
+    // 数据块的索引，每个数据块在下一个数据块的第一个 key 写入时才能确定分隔 key
+    struct IndexPartition
+    {
+        std::vector<uint8_t> encoded;
+        std::string last_separator;
+        size_t first_block;
+    };
+    size_t num_blocks = 0;
+    std::optional<BlockMeta> pending_meta; // 还没有写入索引的数据块
+    std::string pending_last_key;
+    size_t index_partition_size; // 每个索引分区的大小，0 表示不分区
+    Block index_partition;
+    size_t indexed_blocks = 0;
+    size_t partition_first_block = 0;
+    std::string last_separator;
+    std::vector<IndexPartition> index_partitions;
+
+    void add_entry(std::string_view key, std::string_view stored_value, uint64_t tranc_id);
+    void add_index_entry(const std::string &separator, const BlockMeta &meta);
+    void finish_index_partition();
+    // 把编码后的 block 加上压缩类型和校验值追加到 out，返回它的位置
+    static BlockMeta write_block(const std::vector<uint8_t> &encoded, CompressionType type, std::vector<uint8_t> &out);
 
 public:
     std::shared_ptr<BloomFilter> bloom_filter;
-    SSTBuilder(size_t block_size, bool with_bloom);
-    void add(const std::string &key, const std::string &value, uint64_t tranc_id = 0);
+    SSTBuilder(size_t block_size, bool with_bloom, CompressionType compression = CompressionType::None);
+    // 大 value 写入 blob 文件(需要先 set_blob_store)，其余的按 SST 中的存储形式写入
+    void add(std::string_view key, std::string_view value, uint64_t tranc_id = 0);
+    // 写入已经是 SST 存储形式的 value，用于 compaction 原样搬运 blob 引用
+    // 指向存活比例过低的 blob 文件的引用会把 value 重写到当前的 blob 文件
+    void add_encoded(std::string_view key, std::string_view stored_value, uint64_t tranc_id = 0);
+    void set_blob_store(std::shared_ptr<BlobStore> store);
+    // 索引超过一个分区时写成两层的分区索引，0 表示总是使用单层索引
+    void set_index_partition_size(size_t size);
     size_t estimated_size() const;
     void finish_block(); // 当前block被写满，然后清空进行下一个block的编码
     std::shared_ptr<SST> build(size_t sst_id, const std::string &path, std::shared_ptr<BlockCache> block_cache);
@@ -3,23 +3,30 @@
 #include <memory>
 #include <optional>
 #include <functional>
+#include "../const.h"
 #include "../../include/block/block_iterator.h"
 #include "../../include/iterator/iterator.h"
 
 class SST;
 class SstIterator;
 
+// 单次读操作的选项，由引擎的读接口一直传到 SST::read_block
+struct ReadOptions
+{
+    bool verify_checksums = LSM_VERIFY_CHECKSUMS; // 从文件读取数据块时是否校验 CRC32C，可信的热点路径可以关闭
+};
+
 // 返回的是第一个满足谓词的位置, 和最后一个满足谓词位置的下一个位置
 // 左闭右开区间
 // predicated 返回值:
 // 0: 满足条件
 // >0: 不满足谓词, 需要往右移动
 // <0: 不满足谓词, 需要往左移动
-std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(uint64_t max_tranc_id, std::shared_ptr<SST> sst, std::function<int(const std::string &)> predicate);
+std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(uint64_t max_tranc_id, std::shared_ptr<SST> sst, std::function<int(const std::string &)> predicate, const ReadOptions &options = ReadOptions());
 
 class SstIterator : public BaseIterator
 {
-    friend std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(std::shared_ptr<SST> sst, uint64_t max_tranc_id, std::function<int(const std::string &)> predicate);
+    friend std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(uint64_t max_tranc_id, std::shared_ptr<SST> sst, std::function<int(const std::string &)> predicate, const ReadOptions &options);
     friend class SST;
     using value_type = std::pair<std::string, std::string>;
     using pointer = value_type *;
@@ -30,15 +37,19 @@ private:
     std::shared_ptr<BlockIterator> m_block_iter;
     mutable std::optional<value_type> cached_value;
     uint64_t max_tranc_id_;
+    ReadOptions options_;
 
     void update_current() const;
     void seek(const std::string &key);
+    // 当前位置 (block 序号, 记录序号)，block 的末尾和没有 block 迭代器时都视为下一个/当前 block 的开头
+    // 比较位置而不是 Block 对象，block 被缓存淘汰后重新读取也能得到相同的结果
+    std::pair<size_t, size_t> position() const;
 
 public:
     void set_block_idx(size_t idx);
     void set_block_it(std::shared_ptr<BlockIterator> it);
-    SstIterator(std::shared_ptr<SST> sst, uint64_t max_tranc_id) : m_sst(std::move(sst)), m_block_idx(0), cached_value(std::nullopt) {}
-    SstIterator(std::shared_ptr<SST> sst, const std::string &key, uint64_t max_tranc_id);
+    SstIterator(std::shared_ptr<SST> sst, uint64_t max_tranc_id, const ReadOptions &options = ReadOptions()); // 指向第一个 block 的第一条记录
+    SstIterator(std::shared_ptr<SST> sst, const std::string &key, uint64_t max_tranc_id, const ReadOptions &options = ReadOptions());
 
     virtual BaseIterator &operator++() override;
     SstIterator operator++(int) = delete; // 方便后续虚函数的实现
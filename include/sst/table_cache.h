@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../const.h"
+#include "../block/block_cache.h"
+#include "sst.h"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 已打开的 SST 的 LRU 缓存
+// SST 在第一次被访问时才打开(读取元数据、顶层索引和布隆过滤器)，引擎启动时不需要打开任何文件；
+// 打开的 SST 超过容量时淘汰最久没有使用的，限制文件描述符的数量和常驻内存的元数据大小。
+// 被淘汰的 SST 如果还被迭代器持有，最后一个引用释放后才关闭文件
+class TableCache
+{
+private:
+    std::string data_dir;
+    size_t capacity_;
+    std::shared_ptr<BlockCache> block_cache;
+    std::mutex mutex_;
+    // 链表头部是最近使用的 SST
+    std::list<std::shared_ptr<SST>> cache_list;
+    std::unordered_map<size_t, std::list<std::shared_ptr<SST>>::iterator> cache_map_;
+    size_t open_count_ = 0;
+
+    void insert(std::shared_ptr<SST> sst); // 调用方需持有 mutex_
+
+public:
+    TableCache(std::string data_dir, size_t capacity, std::shared_ptr<BlockCache> block_cache);
+
+    // sst的文件格式：data_dir/sst_<sst_id>
+    std::string get_sst_path(size_t sst_id) const;
+
+    // 不在缓存中时从文件打开，文件不存在或损坏时抛出异常
+    std::shared_ptr<SST> get(size_t sst_id);
+    // 刚生成的 SST 已经打开，直接放入缓存
+    void put(std::shared_ptr<SST> sst);
+    // 从缓存中移除并删除文件
+    void remove(size_t sst_id);
+    void clear();
+
+    size_t size();       // 当前打开的 SST 数量
+    size_t open_count(); // 从文件打开 SST 的总次数
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 class BloomFilter
@@ -17,10 +18,10 @@ private:
     size_t num_bits_;   // 位数组的总长度
 
 private:
-    size_t hash1(const std::string &key) const;
-    size_t hash2(const std::string &key) const;
+    size_t hash1(std::string_view key) const;
+    size_t hash2(std::string_view key) const;
 
-    size_t hash(const std::string &key, size_t idx) const;
+    size_t hash(size_t h1, size_t h2, size_t idx) const;
 
 public:
     BloomFilter();
@@ -31,8 +32,8 @@ public:
     // 带位数的特殊构造，用于反序列化的场景
     BloomFilter(size_t expected_elements, double false_positive_rate, size_t num_bits);
 
-    void add(const std::string &key);                     // 添加元素到布隆过滤器中
-    bool possibly_contains(const std::string &key) const; // 判断布隆过滤器中是否存在某个元素
+    void add(std::string_view key);                     // 添加元素到布隆过滤器中
+    bool possibly_contains(std::string_view key) const; // 判断布隆过滤器中是否存在某个元素
 
     std::vector<uint8_t> encode(); // 序列号化数组为字节流（用于持久化存储）
 
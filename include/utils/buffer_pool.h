@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../const.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct BufferPoolStats
+{
+    uint64_t acquires;           // acquire 的次数
+    uint64_t reuses;             // 从池中取到现成缓冲区的次数
+    uint64_t allocations;        // 池中没有合适的缓冲区，新分配的次数
+    uint64_t releases;           // 归还到池中的次数
+    uint64_t discards;           // 池已满或大小不合适，直接释放的次数
+    uint64_t object_allocations; // 新分配对象内存的次数
+    uint64_t object_reuses;      // 复用对象内存的次数
+    size_t pooled_bytes;         // 池中空闲缓冲区的总容量
+};
+
+// 按大小分级的缓冲区池
+// SST 读取 block 时每次未命中缓存都要分配读缓冲区和 block 对象，缓存淘汰时再释放，
+// 扫描时 malloc/free 非常频繁。这里把释放的缓冲区按容量放入 2 的幂次的大小级别，
+// 之后的读取直接取出复用；block 对象(连同 shared_ptr 的控制块)通过 PoolAllocator 复用固定大小的内存
+// 小于 1KB 或大于 1MB 的缓冲区不进入池
+class BufferPool
+{
+private:
+    static constexpr size_t MIN_SHIFT = 10; // 1KB
+    static constexpr size_t MAX_SHIFT = 20; // 1MB
+    static constexpr size_t NUM_CLASSES = MAX_SHIFT - MIN_SHIFT + 1;
+
+    struct SizeClass
+    {
+        std::mutex mtx;
+        std::vector<std::vector<uint8_t>> buffers;
+    };
+    std::array<SizeClass, NUM_CLASSES> classes;
+
+    std::mutex object_mtx;
+    std::unordered_map<size_t, std::vector<void *>> free_objects; // 按对象大小分开的空闲内存
+
+    std::atomic<size_t> capacity; // 池中空闲缓冲区总容量的上限，为 0 时不复用
+    std::atomic<size_t> pooled_bytes{0};
+
+    std::atomic<uint64_t> acquires{0};
+    std::atomic<uint64_t> reuses{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> releases{0};
+    std::atomic<uint64_t> discards{0};
+    std::atomic<uint64_t> object_allocations{0};
+    std::atomic<uint64_t> object_reuses{0};
+
+    static int class_of_size(size_t size);         // 能容纳 size 的最小级别，超出范围时返回 -1(不使用池)
+    static int class_of_capacity(size_t capacity); // 容量不小于级别大小的最大级别，超出范围时返回 -1
+
+public:
+    explicit BufferPool(size_t capacity = LSM_BUFFER_POOL_CAPACITY);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // 读取 SST、解压 block 使用的全局池
+    static BufferPool &global();
+
+    // 返回 size() == size 的缓冲区，内容未定义
+    std::vector<uint8_t> acquire(size_t size);
+    // 归还缓冲区，之后 buf 为空
+    void release(std::vector<uint8_t> &&buf);
+
+    void *allocate_object(size_t size);
+    void deallocate_object(void *p, size_t size);
+
+    void set_capacity(size_t capacity); // 调小时立即释放多出的缓冲区
+    void clear();                       // 释放池中所有空闲的缓冲区和对象内存
+    BufferPoolStats stats() const;
+    void reset_stats();
+};
+
+// 配合 std::allocate_shared 使用，单个对象的内存从 BufferPool::global() 中复用
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        if (n != 1)
+        {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T *>(BufferPool::global().allocate_object(sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        if (n != 1)
+        {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+        BufferPool::global().deallocate_object(p, sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const { return false; }
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// SST 数据块的压缩算法，数值会写入文件，不能修改已有的值
+enum class CompressionType : uint8_t
+{
+    None = 0,
+    LZ = 1, // 仓库内实现的 LZ77 类压缩，格式与 LZ4 的 block 格式类似
+};
+
+// LZ 压缩格式：
+// | 原始长度(uint32_t) | sequence | sequence | ... |
+// sequence: | token(uint8_t) | 字面量长度扩展 | 字面量 | offset(uint16_t) | 匹配长度扩展 |
+// token 的高 4 位是字面量长度，低 4 位是匹配长度减 4，为 15 时后面跟着扩展字节，
+// 扩展字节逐个累加，直到遇到一个小于 255 的字节
+// 最后一个 sequence 只有字面量，没有 offset 和匹配部分
+class Compression
+{
+public:
+    // 把 [src, src + len) 按 type 压缩后追加到 out
+    // 压缩后不比原数据小时不追加任何数据，返回 CompressionType::None，调用方应写入原数据
+    static CompressionType compress(CompressionType type, const uint8_t *src, size_t len, std::vector<uint8_t> &out);
+
+    // 解压 type 类型的数据，数据损坏时抛出 std::runtime_error
+    static std::vector<uint8_t> decompress(CompressionType type, const uint8_t *src, size_t len);
+
+private:
+    static bool lz_compress(const uint8_t *src, size_t len, std::vector<uint8_t> &out);
+    static std::vector<uint8_t> lz_decompress(const uint8_t *src, size_t len);
+};
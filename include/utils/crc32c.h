@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C(Castagnoli 多项式)，用于 SST 中数据块和元数据块的校验
+// 支持 SSE4.2 的 x86 CPU 上使用 crc32 指令，否则使用查表实现，两者结果相同
+// crc 是之前数据的校验值，可以分段计算
+uint32_t crc32c(const void *data, size_t len, uint32_t crc = 0);
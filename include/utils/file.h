@@ -45,7 +45,7 @@ public:
   // 打开文件对象
   static FileObj open(const std::string &path, bool create);
 
-  // 读取并返回切片
+  // 读取并返回切片，缓冲区来自 BufferPool::global()，用完后可以归还
   std::vector<uint8_t> read_to_slice(size_t offset, size_t length);
 
   // 读取 uint8_t
@@ -31,6 +31,7 @@ public:
 
   // 读取数据
   std::vector<uint8_t> read(size_t offset, size_t length);
+  void read(size_t offset, void *data, size_t length);
 
   // 同步
   bool sync();
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 变长整数编码：每个字节的低 7 位保存数据，最高位为 1 表示后面还有字节，低位在前
+// 小于 128 的值只占一个字节，uint64_t 最多占 10 个字节
+
+inline size_t varint_length(uint64_t v)
+{
+    size_t len = 1;
+    while (v >= 0x80)
+    {
+        v >>= 7;
+        len++;
+    }
+    return len;
+}
+
+// 写入到 p，返回写入后的位置
+inline uint8_t *encode_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        *p++ = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+inline void put_varint(std::vector<uint8_t> &out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// 从 [p, limit) 中解码，返回解码后的位置，数据不完整或超过 10 个字节时返回 nullptr
+inline const uint8_t *decode_varint(const uint8_t *p, const uint8_t *limit, uint64_t &v)
+{
+    // 单字节是最常见的情况
+    if (p < limit && *p < 0x80)
+    {
+        v = *p;
+        return p + 1;
+    }
+    uint64_t result = 0;
+    for (int shift = 0; shift <= 63 && p < limit; shift += 7)
+    {
+        uint64_t byte = *p++;
+        result |= (byte & 0x7f) << shift;
+        if (byte < 0x80)
+        {
+            v = result;
+            return p;
+        }
+    }
+    return nullptr;
+}
@@ -1,337 +1,543 @@
 #pragma once
 #include "../../include/block/block.h"
+#include "../../include/const.h"
+#include "../../include/utils/buffer_pool.h"
+#include "../../include/utils/crc32c.h"
+#include "../../include/utils/varint.h"
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <optional>
 
-// 从Block的数据中提取指定偏移量位置的事务ID
-uint64_t Block::get_tranc_id_at(size_t offset) const
+// 编码末尾的 num_restarts 和 num_entries
+static constexpr size_t BLOCK_TRAILER_SIZE = 2 * sizeof(uint32_t);
+
+// num_restarts 的最高位表示是否有哈希索引
+static constexpr uint32_t HASH_INDEX_FLAG = 0x80000000;
+// 哈希桶的特殊值，重启点超过 HASH_MAX_RESTART 个时不生成哈希索引
+static constexpr uint8_t HASH_EMPTY = 0xff;
+static constexpr uint8_t HASH_COLLISION = 0xfe;
+static constexpr size_t HASH_MAX_RESTART = 0xfd;
+
+Block::Block(size_t capacity, bool with_hash_index) : capacity(capacity), with_hash_index(with_hash_index) {}
+
+Block::~Block()
+{
+    BufferPool::global().release(std::move(data));
+}
+
+Block::Entry Block::decode_entry(size_t offset) const
+{
+    Entry entry;
+    uint64_t shared_len;
+    uint64_t unshared_len;
+    uint64_t value_len;
+    const uint8_t *begin = data.data();
+    const uint8_t *limit = begin + (decoded ? restarts_offset : data.size());
+    const uint8_t *p = begin + offset;
+    if ((p = decode_varint(p, limit, shared_len)) == nullptr ||
+        (p = decode_varint(p, limit, unshared_len)) == nullptr ||
+        (p = decode_varint(p, limit, value_len)) == nullptr ||
+        static_cast<uint64_t>(limit - p) < unshared_len + value_len)
+    {
+        throw std::runtime_error("Invalid encoded block: corrupted entry");
+    }
+
+    const char *key_ptr = reinterpret_cast<const char *>(p);
+    entry.shared_len = shared_len;
+    entry.key_suffix = std::string_view(key_ptr, unshared_len);
+    entry.value = std::string_view(key_ptr + unshared_len, value_len);
+    p += unshared_len + value_len;
+    if ((p = decode_varint(p, limit, entry.tranc_id)) == nullptr)
+    {
+        throw std::runtime_error("Invalid encoded block: corrupted entry");
+    }
+    entry.next_offset = p - begin;
+    return entry;
+}
+
+size_t Block::get_restart(size_t restart_idx) const
 {
-    uint64_t key_len; // 存储key长度
-    memcpy(&key_len, data.data() + offset, sizeof(uint16_t));
-
-    // 计算value长度的位置
-    size_t value_len_ops = offset + sizeof(uint16_t) + key_len;
-    uint16_t value_len;
-    memcpy(&value_len, data.data() + value_len_ops, sizeof(uint16_t));
-
-    // 计算事务id的位置
-    size_t tranc_id_ops = value_len_ops + sizeof(uint16_t) + value_len;
-    uint64_t tranc_id;
-    memcpy(&tranc_id, data.data() + tranc_id_ops, sizeof(uint64_t));
-    return tranc_id;
+    if (!decoded)
+    {
+        return restarts[restart_idx];
+    }
+    uint32_t offset;
+    memcpy(&offset, data.data() + restarts_offset + restart_idx * sizeof(uint32_t), sizeof(uint32_t));
+    return offset;
 }
 
-Block::Block(size_t capacity) : capacity(capacity) {}
+std::string_view Block::get_restart_key(size_t restart_idx) const
+{
+    // 重启点的 shared_len 为 0，后缀就是完整的 key
+    return decode_entry(get_restart(restart_idx)).key_suffix;
+}
+
+template <typename Before>
+size_t Block::find_restart(Before before) const
+{
+    size_t left = 0;
+    size_t right = num_restarts;
+    // 在 [left, right) 中找第一个不满足 before 的重启点
+    while (left < right)
+    {
+        size_t mid = left + (right - left) / 2;
+        if (before(get_restart_key(mid)))
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left == 0 ? 0 : left - 1;
+}
 
 std::vector<uint8_t> Block::encode()
 {
     // 计算总大小
-    size_t total_bytes = data.size() + offsets.size() * sizeof(uint16_t) + sizeof(uint16_t);
+    size_t total_bytes = cur_size();
+
+    // 解码得到的 block 中已经是编码后的数据
+    if (decoded)
+    {
+        return std::vector<uint8_t>(data.begin(), data.begin() + total_bytes);
+    }
 
     std::vector<uint8_t> encoded(total_bytes, 0);
 
     // 1.复制data
     memcpy(encoded.data(), data.data(), data.size() * sizeof(uint8_t));
 
-    // 2.复制offsets
-    size_t offset_pos = data.size();
-    memcpy(encoded.data() + offset_pos, offsets.data(), offsets.size() * sizeof(uint16_t));
+    // 2.复制重启点
+    size_t restart_pos = data.size();
+    memcpy(encoded.data() + restart_pos, restarts.data(), restarts.size() * sizeof(uint32_t));
 
-    // 3.写入extra
-    size_t num_pos = data.size() + offsets.size() * sizeof(uint16_t);
-    uint16_t num_elements = offsets.size();
-    memcpy(encoded.data() + num_pos, &num_elements, sizeof(uint16_t));
+    // 3.写入哈希索引
+    size_t num_pos = restart_pos + restarts.size() * sizeof(uint32_t);
+    uint32_t restart_count = num_restarts;
+    size_t index_size = hash_index_size();
+    if (index_size > 0)
+    {
+        uint16_t bucket_count = index_size - sizeof(uint16_t);
+        uint8_t *buckets = encoded.data() + num_pos;
+        memset(buckets, HASH_EMPTY, bucket_count);
+        for (auto &[hash, restart_idx] : key_hashes)
+        {
+            uint8_t &bucket = buckets[hash % bucket_count];
+            if (bucket == HASH_EMPTY)
+            {
+                bucket = restart_idx;
+            }
+            else if (bucket != restart_idx)
+            {
+                // 同一个重启段中的 key 共用一个桶不算冲突
+                bucket = HASH_COLLISION;
+            }
+        }
+        memcpy(buckets + bucket_count, &bucket_count, sizeof(uint16_t));
+        num_pos += index_size;
+        restart_count |= HASH_INDEX_FLAG;
+    }
+
+    // 4.写入重启点数量和记录数量
+    uint32_t num_elements = num_entries;
+    memcpy(encoded.data() + num_pos, &restart_count, sizeof(uint32_t));
+    memcpy(encoded.data() + num_pos + sizeof(uint32_t), &num_elements, sizeof(uint32_t));
 
     return encoded;
 }
 
-std::shared_ptr<Block> Block::decode(const std::vector<uint8_t> &encoded, bool with_hash)
+std::shared_ptr<Block> Block::decode(std::vector<uint8_t> encoded, bool with_hash)
 {
-    // 创建对象
-    auto block = std::make_shared<Block>();
+    // 创建对象，block 对象和控制块的内存从池中复用
+    auto block = std::allocate_shared<Block>(PoolAllocator<Block>());
+
+    size_t encoded_size = encoded.size();
+    if (with_hash)
+    {
+        if (encoded_size < sizeof(uint32_t))
+        {
+            throw std::runtime_error("Invalid encoded block: size too small");
+        }
+        encoded_size -= sizeof(uint32_t);
+        uint32_t stored_crc;
+        memcpy(&stored_crc, encoded.data() + encoded_size, sizeof(uint32_t));
+
+        if (stored_crc != crc32c(encoded.data(), encoded_size))
+        {
+            throw std::runtime_error("Invalid encoded block: checksum mismatch");
+        }
+    }
 
     // 安全性检查
-    if (encoded.size() < sizeof(uint16_t))
+    if (encoded_size < BLOCK_TRAILER_SIZE)
     {
         throw std::runtime_error("Invalid encoded block: size too small");
     }
 
     // 从后向前解析
-    // 读取元素个数
-    uint16_t num_elemts;
-    size_t num_elemts_pos = encoded.size() - sizeof(uint16_t);
-
-    if (with_hash)
+    uint32_t num_restarts;
+    uint32_t num_elements;
+    size_t num_pos = encoded_size - BLOCK_TRAILER_SIZE;
+    memcpy(&num_restarts, encoded.data() + num_pos, sizeof(uint32_t));
+    memcpy(&num_elements, encoded.data() + num_pos + sizeof(uint32_t), sizeof(uint32_t));
+
+    // 哈希索引
+    if (num_restarts & HASH_INDEX_FLAG)
     {
-        num_elemts_pos -= sizeof(uint32_t);
-        auto hash_pos = encoded.size() - sizeof(uint32_t);
-        uint32_t hash_value;
-        memcpy(&hash_value, encoded.data() + hash_pos, sizeof(uint32_t));
-
-        uint32_t compute_hash = std::hash<std::string_view>{}(
-            std::string_view(reinterpret_cast<const char *>(encoded.data()),
-                             encoded.size() - sizeof(uint32_t)));
-
-        if (hash_value != compute_hash)
+        num_restarts &= ~HASH_INDEX_FLAG;
+        uint16_t bucket_count;
+        if (num_pos < sizeof(uint16_t))
         {
-            throw std::runtime_error("Invalid encoded block: hash value mismatch");
+            throw std::runtime_error("Invalid encoded data size");
         }
+        num_pos -= sizeof(uint16_t);
+        memcpy(&bucket_count, encoded.data() + num_pos, sizeof(uint16_t));
+        if (bucket_count == 0 || num_pos < bucket_count)
+        {
+            throw std::runtime_error("Invalid encoded data size");
+        }
+        num_pos -= bucket_count;
+        block->hash_index_offset = num_pos;
+        block->num_buckets = bucket_count;
     }
 
-    memcpy(&num_elemts, encoded.data() + num_elemts_pos, sizeof(uint16_t));
-
     // 验证数据大小
-    // 验证解码过程中接受到的编码数据encoded是否有足够的字节数来正确表示一个Block对象
-    size_t required_size = sizeof(uint16_t) + num_elemts * sizeof(uint16_t);
-    if (encoded.size() < required_size)
+    size_t restart_bytes = num_restarts * sizeof(uint32_t);
+    if (num_pos < restart_bytes ||
+        num_restarts != (num_elements + LSM_BLOCK_RESTART_INTERVAL - 1) / LSM_BLOCK_RESTART_INTERVAL)
     {
         throw std::runtime_error("Invalid encoded data size");
     }
 
-    // 计算各部分的位置
-    size_t offset_section_start = num_elemts_pos - num_elemts * sizeof(uint16_t);
+    // 只记录重启点的位置，数据段直接使用读出的缓冲区
+    block->restarts_offset = num_pos - restart_bytes;
+    block->num_restarts = num_restarts;
+    block->num_entries = num_elements;
+    block->data = std::move(encoded);
+    block->decoded = true;
 
-    // 读取偏移数组
-    block->offsets.resize(num_elemts);
-    memcpy(block->offsets.data(), encoded.data() + offset_section_start, num_elemts * sizeof(uint16_t));
-
-    // 复制数据段
-    block->data.resize(offset_section_start);
-    block->data.assign(encoded.begin(), encoded.begin() + offset_section_start);
+    std::vector<std::string_view> restart_keys;
+    restart_keys.reserve(num_restarts);
+    for (size_t i = 0; i < num_restarts; i++)
+    {
+        restart_keys.push_back(block->get_restart_key(i));
+    }
+    block->restart_index.build(restart_keys);
 
     return block;
 }
 
 size_t Block::cur_size() const
 {
-    return data.size() + offsets.size() * sizeof(uint16_t) + sizeof(uint16_t);
+    if (decoded)
+    {
+        size_t index_size = num_buckets > 0 ? num_buckets + sizeof(uint16_t) : 0;
+        return restarts_offset + num_restarts * sizeof(uint32_t) + index_size + BLOCK_TRAILER_SIZE;
+    }
+    return data.size() + num_restarts * sizeof(uint32_t) + hash_index_size() + BLOCK_TRAILER_SIZE;
+}
+
+size_t Block::hash_index_size() const
+{
+    // 重启点编号需要放进一个字节
+    if (!with_hash_index || key_hashes.empty() || num_restarts > HASH_MAX_RESTART)
+    {
+        return 0;
+    }
+    size_t bucket_count = static_cast<size_t>(key_hashes.size() / LSM_BLOCK_HASH_UTIL_RATIO) + 1;
+    return bucket_count + sizeof(uint16_t);
 }
 
 size_t Block::size()
 {
-    return offsets.size();
+    return num_entries;
 }
 
 bool Block::is_empty() const
 {
-    return offsets.empty();
+    return num_entries == 0;
 }
 
 // tranc_id：事务ID，需要同步持久化
 // 事务id持久化时必然时正整数
 // 事务id为0时，表示不开启事务功能，但不可能出现在实际的文件持久化内容中
-bool Block::add_entry(const std::string key, const std::string &value, uint64_t tranc_id, bool force_write)
+bool Block::add_entry(std::string_view key, std::string_view value, uint64_t tranc_id, bool force_write)
 {
-    if (!force_write && cur_size() + key.size() + value.size() + 3 * sizeof(uint16_t) > capacity)
+    if (decoded)
+    {
+        throw std::runtime_error("Cannot add entry to a decoded block");
+    }
+
+    bool is_restart = num_entries % LSM_BLOCK_RESTART_INTERVAL == 0;
+    size_t shared_len = 0;
+    if (!is_restart)
+    {
+        size_t max_shared = std::min(last_key.size(), key.size());
+        while (shared_len < max_shared && last_key[shared_len] == key[shared_len])
+        {
+            shared_len++;
+        }
+    }
+
+    // 计算entry的大小 header + key 的后缀 + value + tranc_id
+    size_t unshared_len = key.size() - shared_len;
+    size_t entry_size = varint_length(shared_len) + varint_length(unshared_len) + varint_length(value.size()) +
+                        unshared_len + value.size() + varint_length(tranc_id);
+    // 空的 block 总是可以写入，避免超过容量的记录无法写入任何 block
+    if (!force_write && num_entries > 0 &&
+        cur_size() + entry_size + (is_restart ? sizeof(uint32_t) : 0) > capacity)
     {
         return false;
     }
 
-    // 计算entries的大小 key_len + key + value_len + value + uint64_t
-    // (事务ID的内容)
-    size_t entry_size = key.size() + value.size() + 2 * sizeof(uint16_t) + sizeof(uint64_t);
     size_t old_size = data.size();
+    if (is_restart)
+    {
+        restarts.push_back(old_size);
+        num_restarts++;
+    }
     data.resize(old_size + entry_size);
+    uint8_t *p = data.data() + old_size;
 
-    // 写入key_len, key
-    uint16_t key_len = key.size();
-    mempcpy(data.data() + old_size, &key_len, sizeof(uint16_t));
-    memcpy(data.data() + old_size + sizeof(uint16_t), key.data(), key_len);
+    // 写入 header
+    p = encode_varint(p, shared_len);
+    p = encode_varint(p, unshared_len);
+    p = encode_varint(p, value.size());
 
-    // 写入value_len, value
-    uint16_t value_len = value.size();
-    memcpy(data.data() + old_size + sizeof(uint16_t) + key_len, &value_len, sizeof(uint16_t));
-    memcpy(data.data() + old_size + sizeof(uint16_t) + key_len + sizeof(uint16_t), value.data(), value_len);
+    // 写入 key 的后缀、value 和事务id
+    memcpy(p, key.data() + shared_len, unshared_len);
+    p += unshared_len;
+    memcpy(p, value.data(), value.size());
+    p += value.size();
+    encode_varint(p, tranc_id);
 
-    // 写入事务id
-    memcpy(data.data() + old_size + sizeof(uint16_t) + key_len + sizeof(uint16_t) + value_len, &tranc_id, sizeof(uint64_t));
+    if (with_hash_index && (num_entries == 0 || key != last_key))
+    {
+        key_hashes.emplace_back(std::hash<std::string_view>{}(key), num_restarts - 1);
+    }
 
-    // 记录偏移量
-    offsets.push_back(old_size);
+    last_key.assign(key.data(), key.size());
+    num_entries++;
     return true;
 }
 
-size_t Block::get_offset_at(size_t idx) const
+// 相同的key是连续分布的, 且相同key按照事务id由大到小排布
+// 这里的逻辑是找到 key 中最接近 tranc_id 的键值对
+// example:
+// tranc: 100
+// get (key1, 100)
+// key1: value3 101
+// key1: value2 98  <- 返回这一条
+// key1: value1 97
+//
+// tranc_id = 0表示不开启事务可见性的限制
+bool Block::seek(std::string_view key, uint64_t tranc_id, size_t &idx, Entry &entry) const
 {
-    if (idx > offsets.size())
+    if (num_entries == 0)
     {
-        throw std::runtime_error("idx out of range");
+        return false;
     }
-    return offsets[idx];
-}
 
-Block::Entry Block::get_entry_at(size_t offset) const
-{
-    Entry entry;
-    entry.key = get_key_at(offset);
-    entry.value = get_value_at(offset);
-    return entry;
+    // 相同的 key 可能跨越重启点，从最后一个 key 小于目标的重启点开始，才能找到 key 的第一条记录
+    return scan(key, tranc_id, seek_restart(key), false, idx, entry);
 }
 
-std::string Block::get_key_at(size_t offset) const
+size_t Block::seek_restart(std::string_view key) const
 {
-    uint16_t key_len;
-    memcpy(&key_len, data.data() + offset, sizeof(uint16_t));
-    return std::string(reinterpret_cast<const char *>(data.data() + offset + sizeof(uint16_t)), key_len);
-}
-
-std::string Block::get_value_at(size_t offset) const
-{
-    uint16_t key_len;
-    memcpy(&key_len, data.data() + offset, sizeof(uint16_t));
-    uint16_t value_len;
-    memcpy(&value_len, data.data() + offset + sizeof(uint16_t) + key_len, sizeof(uint16_t));
-    return std::string(reinterpret_cast<const char *>(data.data() + offset + sizeof(uint16_t) + key_len + sizeof(uint16_t)), value_len);
+    if (!restart_index.empty())
+    {
+        size_t first_not_less = restart_index.lower_bound(key, [&](size_t i)
+                                                          { return get_restart_key(i); });
+        return first_not_less == 0 ? 0 : first_not_less - 1;
+    }
+    return find_restart([&](std::string_view restart_key)
+                        { return restart_key < key; });
 }
 
-bool Block::is_same_key(size_t idx, const std::string &target_key) const
+size_t Block::lower_bound(std::string_view key, std::string_view &value) const
 {
-    if (idx >= offsets.size())
+    if (num_entries == 0)
     {
-        return false;
+        return 0;
     }
 
-    return get_key_at(offsets[idx]) == target_key;
+    // scan 在遇到第一条不小于 key 的记录时停下，idx 就是它的下标
+    size_t idx;
+    Entry entry;
+    scan(key, 0, seek_restart(key), false, idx, entry);
+    if (idx < num_entries)
+    {
+        value = entry.value;
+    }
+    return idx;
 }
 
-// 相同的key是连续分布的, 且相同key按照事务id由大到小排布
-// 这里的逻辑是找到最接近 tranc_id 的键值对的索引位置
-// example:
-// tranc: 100
-// get (key1, 100)
-// key1: value1 97
-// key1: value2 98
-// key1: value3 101
-//
-// tranc_id = 0表示不开启事务可见性的限制
-int Block::adjust_idx_by_tranc_id(size_t idx, uint64_t tranc_id)
+std::string_view Block::value_at(size_t idx) const
 {
-    if (idx >= offsets.size())
+    if (idx >= num_entries)
     {
-        return -1; // 索引越界
+        throw std::out_of_range("Block entry index out of range");
     }
+    // value 不依赖前面的记录，只需要从重启点跳过前面的记录
+    size_t offset = get_restart(idx / LSM_BLOCK_RESTART_INTERVAL);
+    Entry entry = decode_entry(offset);
+    for (size_t i = idx / LSM_BLOCK_RESTART_INTERVAL * LSM_BLOCK_RESTART_INTERVAL; i < idx; i++)
+    {
+        entry = decode_entry(entry.next_offset);
+    }
+    return entry.value;
+}
 
-    auto target_key = get_key_at(offsets[idx]);
-
-    if (tranc_id != 0)
+size_t Block::partition_point(const std::function<bool(std::string_view)> &before) const
+{
+    if (num_entries == 0)
     {
-        auto cur_tranc_id = get_tranc_id_at(offsets[idx]);
-        if (cur_tranc_id <= tranc_id)
-        {
-            // 当前事务可见的，需要向前继续判断
-            // 向前判断的前提是key相同
-            size_t pre_idx = idx;
-            while (pre_idx > 0 && is_same_key(pre_idx - 1, target_key))
-            {
-                pre_idx--;
-                auto new_tranc_id = get_tranc_id_at(offsets[pre_idx]);
-                if (new_tranc_id > tranc_id)
-                {
-                    // 不可见，返回之前位置的索引
-                    return pre_idx + 1;
-                }
-            }
-            return pre_idx;
-        }
-        else
-        {
-            // 当前记录不可见，向后查找
-            size_t next_idx = idx + 1;
-            while (next_idx < offsets.size() && is_same_key(next_idx, target_key))
-            {
-                auto new_tranc_id = get_tranc_id_at(offsets[next_idx]);
-                if (new_tranc_id <= tranc_id)
-                {
-                    return next_idx; // 找到可见记录
-                }
-                next_idx++;
-            }
-            return -1;
-        }
+        return 0;
     }
-    else
+
+    // 先在重启点上二分，再从重启点开始还原 key 顺序查找
+    size_t restart_idx = find_restart(before);
+    size_t offset = get_restart(restart_idx);
+    std::string key;
+    for (size_t idx = restart_idx * LSM_BLOCK_RESTART_INTERVAL; idx < num_entries; idx++)
     {
-        // 没有开启事务的情况
-        size_t pre_idx = idx;
-        while (pre_idx > 0 && is_same_key(pre_idx - 1, target_key))
+        Entry entry = decode_entry(offset);
+        offset = entry.next_offset;
+        key.resize(entry.shared_len);
+        key.append(entry.key_suffix);
+        if (!before(key))
         {
-            pre_idx--;
+            return idx;
         }
-        return pre_idx;
     }
+    return num_entries;
 }
 
-std::optional<size_t> Block::get_idx_binary(const std::string &key, uint64_t tranc_id)
+bool Block::seek_point(std::string_view key, uint64_t tranc_id, size_t &idx, Entry &entry) const
 {
-    if (offsets.empty())
+    if (num_buckets == 0)
     {
-        return std::nullopt;
+        return seek(key, tranc_id, idx, entry);
     }
 
-    // 二分查找
-    int left = 0;
-    int right = offsets.size() - 1;
-
-    while (left <= right)
+    size_t bucket = std::hash<std::string_view>{}(key) % num_buckets;
+    uint8_t restart_idx = data[hash_index_offset + bucket];
+    if (restart_idx == HASH_EMPTY)
     {
-        int mid = (left + right) / 2;
-        size_t mid_offset = offsets[mid];
-
-        int cmp = compare_key(mid_offset, key);
+        // 没有任何 key 哈希到这个桶
+        return false;
+    }
+    if (restart_idx == HASH_COLLISION || restart_idx >= num_restarts)
+    {
+        return seek(key, tranc_id, idx, entry);
+    }
+    return scan(key, tranc_id, restart_idx, true, idx, entry);
+}
 
-        if (cmp == 0)
+bool Block::scan(std::string_view key, uint64_t tranc_id, size_t restart_idx, bool bounded, size_t &idx, Entry &entry) const
+{
+    // 不还原完整的 key，只维护上一条记录与目标 key 的公共前缀长度 matched，
+    // 上一条记录总是小于目标 key 或者等于目标 key(版本不可见)
+    // 当前记录与上一条记录共享 shared_len 字节：
+    // shared_len < matched：当前记录在 shared_len 处的字节大于上一条记录，也就大于目标 key
+    // shared_len > matched：当前记录与上一条记录在 matched 处相同，仍然小于目标 key
+    // shared_len == matched：只需要比较后缀和目标 key 剩下的部分
+    size_t matched = 0;
+    bool key_found = false; // 是否已经遇到过目标 key 的记录
+    size_t first_idx = restart_idx * LSM_BLOCK_RESTART_INTERVAL;
+    size_t offset = get_restart(restart_idx);
+    for (idx = first_idx; idx < num_entries; idx++)
+    {
+        entry = decode_entry(offset);
+        offset = entry.next_offset;
+        if (idx % LSM_BLOCK_RESTART_INTERVAL == 0)
         {
-            // 找到了key，但还需要判断事务id的可见性
-            auto new_mid = adjust_idx_by_tranc_id(mid, tranc_id);
-            if (new_mid != -1)
+            // 哈希索引指向的重启段中没有这个 key
+            if (bounded && idx != first_idx && !key_found)
             {
-                return std::nullopt; // 没有找到可见的记录
+                return false;
             }
-            return mid;
+            // 重启点保存完整的 key，shared_len 为 0 并不表示与上一条记录没有公共前缀
+            matched = 0;
         }
-        else if (cmp < 0)
+        else if (entry.shared_len < matched)
         {
-            left = mid + 1;
+            return false;
         }
-        else
+        else if (entry.shared_len > matched)
         {
-            right = mid - 1;
+            continue;
         }
-    }
 
-    return std::nullopt;
+        std::string_view rest = key.substr(matched);
+        size_t common = 0;
+        size_t max_common = std::min(rest.size(), entry.key_suffix.size());
+        while (common < max_common && rest[common] == entry.key_suffix[common])
+        {
+            common++;
+        }
+        int cmp = entry.key_suffix.compare(rest);
+        if (cmp > 0)
+        {
+            return false;
+        }
+        matched += common;
+        if (cmp == 0)
+        {
+            key_found = true;
+            if (tranc_id == 0 || entry.tranc_id <= tranc_id)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
-int Block::compare_key(size_t offset, const std::string &target)
+std::optional<size_t> Block::get_idx_binary(std::string_view key, uint64_t tranc_id)
 {
-    std::string key = get_key_at(offset);
-
-    return key.compare(target);
+    size_t idx;
+    Entry entry;
+    if (!seek(key, tranc_id, idx, entry))
+    {
+        return std::nullopt;
+    }
+    return idx;
 }
 
 std::string Block::get_first_key()
 {
-    if (data.empty() || offsets.empty())
+    if (num_entries == 0)
     {
         return "";
     }
 
-    // 读取第一个key
-    uint16_t key_len;
-    memcpy(&key_len, data.data(), sizeof(uint16_t)); // 从data的起始位置读取一个uint16_t类型的值作为key的长度。
+    // 第一条记录是重启点，保存着完整的 key
+    return std::string(get_restart_key(0));
+}
 
-    return std::string(reinterpret_cast<const char *>(data.data() + sizeof(uint16_t)), key_len); // 根据读取的长度，从data中提取对应的字节序列并转换为字符串返回。
+std::optional<std::string_view> Block::get_value_view(std::string_view key, uint64_t tranc_id) const
+{
+    size_t idx;
+    Entry entry;
+    if (!seek_point(key, tranc_id, idx, entry))
+    {
+        return std::nullopt;
+    }
+    return entry.value;
 }
 
-std::optional<std::string> Block::get_value_binary(const std::string &key, uint64_t tranc_id)
+std::optional<std::string> Block::get_value_binary(std::string_view key, uint64_t tranc_id)
 {
-    auto idx = get_idx_binary(key, tranc_id);
-    if (idx.has_value())
+    auto value = get_value_view(key, tranc_id);
+    if (!value.has_value())
     {
-        return get_value_at(offsets[idx.value()]);
+        return std::nullopt;
     }
-    return std::nullopt;
+    return std::string(*value);
 }
 
 // 返回的是第一个满足谓词的位置，和最后一个满足谓词位置的下一个位置
@@ -342,86 +548,35 @@ std::optional<std::string> Block::get_value_binary(const std::string &key, uint6
 // <0：不满足谓词，需要向左移动
 std::optional<std::pair<std::shared_ptr<BlockIterator>, std::shared_ptr<BlockIterator>>> Block::get_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate)
 {
-    // 如果offsets为空，则表示当前块中没有数据，直接返回
-    if (offsets.empty())
+    // 如果block为空，直接返回
+    if (num_entries == 0)
     {
         return std::nullopt;
     }
 
-    // 第一次二分查找到第一个满足谓词的位置
-    int left = 0;
-    int right = offsets.size() - 1;
-    int first = -1;       // 真正的区间的起始位置
-    int first_first = -1; // 第一找到的谓词位置
-
-    while (left <= right)
+    // 在重启点上二分，找到区间的起点和终点所在的重启段，再在段内顺序查找
+    // 起点：第一个 predicate <= 0 的记录，从最后一个 predicate > 0 的重启点开始查找
+    size_t restart_idx = find_restart([&](std::string_view restart_key)
+                                      { return predicate(std::string(restart_key)) > 0; });
+    auto it_begin = std::make_shared<BlockIterator>(shared_from_this(), restart_idx * LSM_BLOCK_RESTART_INTERVAL, tranc_id);
+    while (it_begin->is_valid() && predicate(it_begin->current_key) > 0)
     {
-        int mid = left + (right - left) / 2;
-        size_t mid_offset = offsets[mid];
-
-        auto mid_key = get_key_at(mid_offset);
-        int direction = predicate(mid_key);
-
-        if (direction < 0)
-        {
-            // 目标在mid左侧
-            right = mid - 1;
-        }
-        else if (direction > 0)
-        {
-            // 在目标mid右侧
-            left = mid + 1;
-        }
-        else
-        {
-            // 目标在mid位置
-            first = mid;
-            if (first_first == -1)
-            {
-                first_first = mid;
-            }
-            // 继续判断左边是否符合
-            right = mid - 1;
-        }
+        ++(*it_begin);
     }
-
-    if (first == -1)
+    if (!it_begin->is_valid() || predicate(it_begin->current_key) != 0)
     {
         return std::nullopt;
     }
 
-    // 继续找到最后一个满足谓词的位置
-    left = first_first;
-    right = offsets.size() - 1;
-    int last = -1;
-    while (left <= right)
+    // 终点：第一个 predicate < 0 的记录，从最后一个 predicate >= 0 的重启点开始查找
+    restart_idx = find_restart([&](std::string_view restart_key)
+                               { return predicate(std::string(restart_key)) >= 0; });
+    size_t end_idx = std::max(restart_idx * LSM_BLOCK_RESTART_INTERVAL, it_begin->current_index);
+    auto it_end = std::make_shared<BlockIterator>(shared_from_this(), end_idx, tranc_id);
+    while (it_end->is_valid() && predicate(it_end->current_key) >= 0)
     {
-        int mid = left + (right - left) / 2;
-        size_t mid_offset = offsets[mid];
-
-        auto mid_key = get_key_at(mid_offset);
-        int direction = predicate(mid_key);
-
-        if (direction < 0)
-        {
-            // 目标在mid左侧
-            right = mid - 1;
-        }
-        else if (direction > 0)
-        {
-            // 目标在mid右侧
-            throw std::runtime_error("block is not sorted");
-        }
-        else
-        {
-            // 目标在mid位置
-            last = mid;
-            // 继续判断右边是否符合
-            left = mid + 1;
-        }
+        ++(*it_end);
     }
-    auto it_begin = std::make_shared<BlockIterator>(shared_from_this(), first, tranc_id);
-    auto it_end = std::make_shared<BlockIterator>(shared_from_this(), last + 1, tranc_id);
 
     return std::make_pair(it_begin, it_end);
 }
@@ -433,5 +588,5 @@ BlockIterator Block::begin(uint64_t tranc_id)
 
 BlockIterator Block::end(uint64_t tranc_id)
 {
-    return BlockIterator(shared_from_this(), offsets.size(), tranc_id);
-}
\ No newline at end of file
+    return BlockIterator(shared_from_this(), num_entries, tranc_id);
+}
@@ -1,30 +1,73 @@
 #include "../../include/block/block_iterator.h"
 #include "../../include/block/block.h"
+#include "../../include/const.h"
 #include <optional>
+#include <stdexcept>
 
 BlockIterator::BlockIterator(std::shared_ptr<Block> b, size_t index, uint64_t tranc_id)
-    : block(std::move(b)), current_index(index), cached_value(std::nullopt), max_tranc_id_(tranc_id) {}
+    : block(std::move(b)), cached_value(std::nullopt), max_tranc_id_(tranc_id)
+{
+    seek_index(index);
+}
 
-BlockIterator::BlockIterator(std::shared_ptr<Block> b, const std::string &key, uint64_t tranc_id)
+BlockIterator::BlockIterator(std::shared_ptr<Block> b, std::string_view key, uint64_t tranc_id)
     : block(std::move(b)), cached_value(std::nullopt), max_tranc_id_(tranc_id)
 {
-    auto key_idx_ops = block->get_idx_binary(key, tranc_id);
-    if (key_idx_ops.has_value())
+    Block::Entry entry;
+    if (!block->seek_point(key, tranc_id, current_index, entry))
     {
-        current_index = key_idx_ops.value();
+        current_index = block->num_entries;
+        return;
     }
-    else
+
+    // 找到的记录的 key 就是目标 key，不需要从重启点重新解码
+    current_key.assign(key.data(), key.size());
+    current_value = entry.value;
+    current_tranc_id = entry.tranc_id;
+    next_offset = entry.next_offset;
+}
+
+void BlockIterator::seek_index(size_t index)
+{
+    if (index >= block->num_entries)
     {
-        current_index = block->offsets.size();
+        current_index = block->num_entries;
+        return;
     }
+
+    // 重启点处的记录保存着完整的 key，从这里开始向后解码
+    size_t restart_idx = index / LSM_BLOCK_RESTART_INTERVAL;
+    current_index = restart_idx * LSM_BLOCK_RESTART_INTERVAL;
+    next_offset = block->get_restart(restart_idx);
+    current_key.clear();
+    decode_next();
+    while (current_index < index)
+    {
+        current_index++;
+        decode_next();
+    }
+}
+
+void BlockIterator::decode_next()
+{
+    auto entry = block->decode_entry(next_offset);
+    current_key.resize(entry.shared_len);
+    current_key.append(entry.key_suffix);
+    current_value = entry.value;
+    current_tranc_id = entry.tranc_id;
+    next_offset = entry.next_offset;
 }
 
 BaseIterator &BlockIterator::operator++()
 {
-    if (block && current_index < block->offsets.size())
+    if (block && current_index < block->num_entries)
     {
         ++current_index;
         cached_value = std::nullopt;
+        if (current_index < block->num_entries)
+        {
+            decode_next();
+        }
     }
     return *this;
 }
@@ -35,7 +78,7 @@ bool BlockIterator::operator==(const BaseIterator &other) const
     {
         return false;
     }
-    auto other2 = dynamic_cast<const BlockIterator &>(other);
+    auto &other2 = dynamic_cast<const BlockIterator &>(other);
     if (block == nullptr && other2.block == nullptr)
     {
         return true;
@@ -78,12 +121,12 @@ BlockIterator::value_type BlockIterator::operator*() const
 
 bool BlockIterator::is_end() const
 {
-    return current_index == block->offsets.size();
+    return current_index == block->num_entries;
 }
 
 bool BlockIterator::is_valid() const
 {
-    return !(current_index == block->offsets.size());
+    return !(current_index == block->num_entries);
 }
 
 IteratorType BlockIterator::get_type() const
@@ -93,13 +136,32 @@ IteratorType BlockIterator::get_type() const
 
 uint64_t BlockIterator::get_tranc_id() const
 {
-    return max_tranc_id_;
+    // 当前记录自身的事务 id
+    if (current_index >= block->num_entries)
+    {
+        return max_tranc_id_;
+    }
+    return current_tranc_id;
+}
+std::string_view BlockIterator::key() const
+{
+    return current_key;
+}
+
+std::string_view BlockIterator::value() const
+{
+    return current_value;
+}
+
+size_t BlockIterator::get_index() const
+{
+    return current_index;
 }
+
 void BlockIterator::update_current() const
 {
-    if (!cached_value && current_index < block->offsets.size())
+    if (!cached_value && current_index < block->num_entries)
     {
-        size_t offset = block->get_offset_at(current_index);
-        cached_value = std::make_pair(block->get_key_at(offset), block->get_value_at(offset));
+        cached_value = std::make_pair(current_key, std::string(current_value));
     }
-}
\ No newline at end of file
+}
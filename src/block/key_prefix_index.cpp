@@ -0,0 +1,90 @@
+#include "../../include/block/key_prefix_index.h"
+#include <algorithm>
+
+void KeyPrefixIndex::build(const std::vector<std::string_view> &keys)
+{
+    common_prefix.clear();
+    sorted.clear();
+    eytzinger.clear();
+    rank.clear();
+    if (keys.empty())
+    {
+        return;
+    }
+
+    // key 有序，第一个和最后一个 key 的公共前缀就是所有 key 的公共前缀
+    std::string_view first = keys.front();
+    std::string_view last = keys.back();
+    size_t common = 0;
+    size_t max_common = std::min(first.size(), last.size());
+    while (common < max_common && first[common] == last[common])
+    {
+        common++;
+    }
+    common_prefix.assign(first.data(), common);
+
+    sorted.reserve(keys.size());
+    for (auto &key : keys)
+    {
+        sorted.push_back(prefix_of(key));
+    }
+
+    eytzinger.resize(keys.size() + 1);
+    rank.resize(keys.size() + 1);
+    size_t i = 0;
+    build_eytzinger(i, 1);
+}
+
+void KeyPrefixIndex::build_eytzinger(size_t &i, size_t k)
+{
+    // 中序遍历完全二叉树，依次填入有序的前缀
+    if (k < eytzinger.size())
+    {
+        build_eytzinger(i, 2 * k);
+        eytzinger[k] = sorted[i];
+        rank[k] = i;
+        i++;
+        build_eytzinger(i, 2 * k + 1);
+    }
+}
+
+uint64_t KeyPrefixIndex::prefix_of(std::string_view key) const
+{
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); i++)
+    {
+        size_t pos = common_prefix.size() + i;
+        uint8_t byte = pos < key.size() ? static_cast<uint8_t>(key[pos]) : 0;
+        prefix = (prefix << 8) | byte;
+    }
+    return prefix;
+}
+
+size_t KeyPrefixIndex::prefix_lower_bound(uint64_t prefix) const
+{
+    size_t n = sorted.size();
+    const uint64_t *tree = eytzinger.data();
+    size_t k = 1;
+    while (k <= n)
+    {
+        // 一个 cache line 放 8 个前缀，k * 8 开始的是往下第 3 层的节点
+        if (k * 8 <= n)
+        {
+            __builtin_prefetch(tree + k * 8);
+        }
+        k = 2 * k + (tree[k] < prefix);
+    }
+    // 去掉最后连续向右走的步数，剩下的就是答案所在的节点，为 0 表示都小于 prefix
+    k >>= __builtin_ffsll(~k);
+    return k == 0 ? n : rank[k];
+}
+
+size_t KeyPrefixIndex::size() const
+{
+    return sorted.size();
+}
+
+bool KeyPrefixIndex::empty() const
+{
+    return sorted.empty();
+}
@@ -3,15 +3,16 @@
 #include "../../include/sst/concat_iterator.h"
 #include "../../include/sst/sst_iterator.h"
 #include <algorithm>
-#include <sstream>
-#include <iomanip>
 #include <filesystem>
+#include <chrono>
 #include <vector>
 
-std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>> LSMEngine::iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate)
+std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>> LSMEngine::iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate,
+                                                                                                    const ReadOptions &options)
 {
     // 1.先从内存部分查询
-    auto mem_result = memtable.iter_monotony_predicate(tranc_id, predicate); // 从内存表查询符合单调行的结果
+    // 保留内存表中的删除标记，由 TwoMergeIterator 用来屏蔽 SST 中的旧记录
+    auto mem_result = memtable.iter_monotony_predicate(tranc_id, predicate, false); // 从内存表查询符合单调行的结果
 
     // 2.再从SST中查询
     std::vector<SearchItem> item_vec; // 存储从SST收集的查询结果
@@ -19,9 +20,16 @@ std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>> LSMEngine::iter_mon
     // 后续实现了高层sst后需要修改这里的逻辑
 
     // 遍历所有的SST文件，sst_id越小表示文件越旧
-    for (auto &[sst_idx, sst] : ssts) // 结构化绑定分解SST索引和对象
+    std::shared_lock<std::shared_mutex> rlock(ssts_mtx); // 刷盘线程会并发修改ssts
+    std::vector<size_t> sst_ids;
+    for (auto &[level, ids] : level_sst_ids)
     {
-        auto result = sst_iters_monotony_predicate(tranc_id, sst, predicate); // 在单个SST中查询
+        sst_ids.insert(sst_ids.end(), ids.begin(), ids.end());
+    }
+    for (auto &sst_idx : sst_ids)
+    {
+        auto sst = table_cache->get(sst_idx);
+        auto result = sst_iters_monotony_predicate(tranc_id, sst, predicate, options); // 在单个SST中查询
         if (!result.has_value())                                              // 没有符合条件的结果则跳过
         {
             continue;
@@ -36,7 +44,8 @@ std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>> LSMEngine::iter_mon
             // 将键值对存入向量，sst_idx取负保证新文件优先级更高
             // 越古老的sst的idx越小，我们需要让新的SST优先放在堆顶
             // 反转符号
-            item_vec.emplace_back(it_begin->first, it_begin->second, -sst_idx, 0, tranc_id);
+            // blob 引用在这里读出 value，之后的合并与 compaction 无关
+            item_vec.emplace_back(it_begin->first, blob_store->resolve(it_begin->second), -sst_idx, 0, tranc_id);
         }
     }
 
@@ -44,25 +53,31 @@ std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>> LSMEngine::iter_mon
     std::shared_ptr<HeapIterator> l0_iter_ptr = make_shared<HeapIterator>(item_vec, 0);
 
     // 4.构造返回结果
-    if (!mem_result.has_value()) // 内存表有查询结果时的处理
+    if (mem_result.has_value()) // 内存表有查询结果时的处理
     {
-        auto [mem_start, mem_end] = mem_result.value();                                 // 解包内存表迭代器
-        std::shared_ptr<HeapIterator> mem_start_ptr = std::make_shared<HeapIterator>(); // 创建智能指针
-        *mem_start_ptr = mem_start;                                                     // 复制迭代器状态 ==> 解引用
-        auto start = TwoMergeIterator(mem_start_ptr, l0_iter_ptr, tranc_id);            // 合并内存和SST的迭代器
-        auto end = TwoMergeIterator(tranc_id);                                          // 结束标记迭代器
-        return std::make_optional(std::make_pair(start, end));                          // 返回迭代器对
+        auto [mem_start, mem_end] = mem_result.value();                                     // 解包内存表迭代器
+        auto mem_start_ptr = std::make_shared<MemMergeIterator>(std::move(mem_start)); // 创建智能指针
+        auto start = TwoMergeIterator(mem_start_ptr, l0_iter_ptr, tranc_id);                // 合并内存和SST的迭代器
+        auto end = TwoMergeIterator(tranc_id);                                              // 结束标记迭代器
+        return std::make_optional(std::make_pair(start, end));                              // 返回迭代器对
     }
     else // 内存表无结果时的处理
     {
-        auto start = TwoMergeIterator(std::make_shared<HeapIterator>(), l0_iter_ptr, tranc_id); // 空内存迭代器
+        auto start = TwoMergeIterator(std::make_shared<MemMergeIterator>(), l0_iter_ptr, tranc_id); // 空内存迭代器
         auto end = TwoMergeIterator(tranc_id);
         return std::make_optional(std::make_pair(start, end));
     }
 }
-LSMEngine::LSMEngine(const std::string path) : data_dir(path)
+LSMEngine::LSMEngine(const std::string path, size_t max_immutable_memtables, MemTableRepType rep_type,
+                     size_t memtable_size_limit)
+    : data_dir(path), memtable(rep_type, memtable_size_limit), memtable_size_limit(memtable_size_limit),
+      max_immutable_memtables(std::max<size_t>(max_immutable_memtables, 1))
 {
+    // 冻结表数量比上限少一个时开始延迟写入
+    slowdown_trigger = std::max<size_t>(this->max_immutable_memtables - 1, 1);
+
     block_cache = std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+    table_cache = std::make_shared<TableCache>(path, LSM_TABLE_CACHE_CAPACITY, block_cache);
 
     // 判断数据库文件
     if (!std::filesystem::exists(path))
@@ -71,7 +86,7 @@ LSMEngine::LSMEngine(const std::string path) : data_dir(path)
     }
     else
     {
-        // 检查sst文件并加载
+        // 检查sst文件，只记录id，SST 在第一次访问时才打开
         for (auto &entry : std::filesystem::directory_iterator(path))
         {
             if (!entry.is_regular_file())
@@ -92,50 +107,160 @@ LSMEngine::LSMEngine(const std::string path) : data_dir(path)
             }
             size_t sst_id = std::stoi(id_str);
 
-            // 加载sst文件
             std::unique_lock<std::shared_mutex> lock(ssts_mtx);
-            std::string sst_path = get_sst_path(sst_id);
-            auto sst = SST::open(sst_id, FileObj::open(sst_path, false), block_cache);
-            ssts[sst_id] = sst;
-
             level_sst_ids[0].push_back(sst_id);
+            next_sst_id = std::max(next_sst_id, sst_id + 1);
         }
         std::sort(level_sst_ids[0].begin(), level_sst_ids[0].end());
         std::reverse(level_sst_ids[0].begin(), level_sst_ids[0].end());
     }
+
+    // 加载已有的 blob 文件
+    // 已有 SST 的 blob 引用在第一次 GC 时才读取，启动时不读取任何 SST，上次退出前已经没有引用的文件在第一次 compaction 后删除
+    blob_store = std::make_shared<BlobStore>(path);
+
+    flush_thread = std::thread(&LSMEngine::flush_worker, this);
 }
 
 LSMEngine::~LSMEngine()
 {
-    while (memtable.get_total_size() > 0)
     {
-        // 刷盘
-        flush();
+        std::lock_guard<std::mutex> lock(flush_mtx);
+        stop_flush = true;
+    }
+    flush_cv.notify_all();
+    flush_done_cv.notify_all();
+    // 刷盘线程退出前会把所有冻结表写入SST
+    flush_thread.join();
+
+    // 后台刷盘已经出错时不再重试；析构函数不能抛出异常
+    if (has_bg_error)
+    {
+        return;
+    }
+    try
+    {
+        while (memtable.get_total_size() > 0)
+        {
+            // 刷盘
+            flush();
+        }
+    }
+    catch (...)
+    {
     }
 }
-void LSMEngine::put(const std::string &key, const std::string &value, uint64_t tranc_id)
+
+void LSMEngine::set_tran_manager(std::shared_ptr<TranManager> manager)
 {
-    memtable.put(key, value, tranc_id);
+    std::lock_guard<std::mutex> lock(flush_mtx);
+    tran_manager = manager;
+}
+
+void LSMEngine::flush_worker()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(flush_mtx);
+            flush_cv.wait(lock, [this]
+                          { return stop_flush || memtable.get_frozen_count() > 0; });
+            if (memtable.get_frozen_count() == 0)
+            {
+                // 收到退出信号，且冻结表已经全部刷盘
+                return;
+            }
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+            // 刷盘线程中的异常不能传播出去，保存下来交给之后的写操作
+            error = std::current_exception();
+        }
 
-    if (memtable.get_cur_size() >= LSM_TOTAL_MEM_SIZE_LIMIT)
+        {
+            // 持有锁再通知，避免写线程检查完条件、还未进入等待时错过通知
+            std::lock_guard<std::mutex> lock(flush_mtx);
+            if (error)
+            {
+                bg_error = error;
+                has_bg_error = true;
+            }
+        }
+        flush_done_cv.notify_all();
+        if (error)
+        {
+            // 出错后停止刷盘，冻结表留在内存中，仍然可以读取
+            return;
+        }
+    }
+}
+
+void LSMEngine::make_room_for_write()
+{
+    if (has_bg_error)
+    {
+        std::lock_guard<std::mutex> lock(flush_mtx);
+        std::rethrow_exception(bg_error);
+    }
+
+    // 冻结表开始堆积时延迟每次写入，给刷盘线程追赶的时间，避免之后写入被完全阻塞
+    if (memtable.get_frozen_count() >= slowdown_trigger)
     {
-        // 如果memtable太大就需要刷盘
-        flush();
+        std::this_thread::sleep_for(std::chrono::microseconds(LSM_WRITE_SLOWDOWN_US));
     }
 }
 
-void LSMEngine::put_batch(const std::vector<std::pair<std::string, std::string>> &kvs, uint64_t tranc_id)
+void LSMEngine::maybe_freeze()
 {
-    memtable.put_batch(kvs, tranc_id);
+    if (memtable.get_cur_size() < memtable_size_limit)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(flush_mtx);
+    // 冻结表数量达到上限，停止写入，直到刷盘线程完成一次刷盘
+    flush_done_cv.wait(lock, [this]
+                       { return stop_flush || bg_error || memtable.get_frozen_count() < max_immutable_memtables; });
+    if (bg_error)
+    {
+        // 这次写入已经在活跃表中，刷盘线程已经停止，不再冻结
+        std::rethrow_exception(bg_error);
+    }
 
-    if (memtable.get_total_size() >= LSM_TOTAL_MEM_SIZE_LIMIT)
+    // 等待期间其他写线程可能已经冻结了活跃表
+    if (memtable.get_cur_size() < memtable_size_limit)
     {
-        // 如果memtable太大就需要刷盘
-        flush();
+        return;
     }
+    memtable.frozen_cur_table();
+    flush_cv.notify_one();
+}
+
+void LSMEngine::put(const std::string &key, const std::string &value, uint64_t tranc_id)
+{
+    make_room_for_write();
+    memtable.put(key, value, tranc_id);
+
+    // 如果memtable太大就冻结，交给刷盘线程
+    maybe_freeze();
+}
+
+void LSMEngine::put_batch(const std::vector<std::pair<std::string, std::string>> &kvs, uint64_t tranc_id)
+{
+    make_room_for_write();
+    memtable.put_batch(kvs, tranc_id);
+
+    // 如果memtable太大就冻结，交给刷盘线程
+    maybe_freeze();
 }
 
-std::optional<std::pair<std::string, uint64_t>> LSMEngine::get(const std::string &key, uint64_t tranc_id)
+std::optional<std::pair<std::string, uint64_t>> LSMEngine::get(const std::string &key, uint64_t tranc_id, const ReadOptions &options)
 {
     // 1.先从memtable中查找
     SkipListIterator value = memtable.get(key, tranc_id);
@@ -152,27 +277,29 @@ std::optional<std::pair<std::string, uint64_t>> LSMEngine::get(const std::string
         }
     }
     // 2. l0_sst查询
-    std::shared_lock<std::shared_mutex> rlock(ssts_mtx);
-    return sst_get_(key, tranc_id);
+    return sst_get_(key, tranc_id, options);
 }
 std::optional<std::pair<std::string, uint64_t>>
-LSMEngine::sst_get_(const std::string &key, uint64_t tranc_id)
+LSMEngine::sst_get_(const std::string &key, uint64_t tranc_id, const ReadOptions &options)
 {
-    // 2. l0_sst查询
+    // 2. 从新到旧逐层查询 SST：L0 中越靠前越新，更高层由 compaction 生成，比低层旧
     std::shared_lock<std::shared_mutex> lock(ssts_mtx);
-    for (auto &sst_id : level_sst_ids[0])
+    for (auto &[level, ids] : level_sst_ids)
     {
-        std::shared_ptr<SST> sst = ssts[sst_id];
-        auto res = sst->get(key, tranc_id);
-        if (res != sst->end(tranc_id))
+        for (auto &sst_id : ids)
         {
-            if ((res->second.size() > 0))
-            {
-                return std::make_pair(res->second, res.get_tranc_id());
-            }
-            else
+            std::shared_ptr<SST> sst = table_cache->get(sst_id);
+            auto res = sst->get(key, tranc_id, options);
+            if (res.is_valid() && res->first == key)
             {
-                return std::nullopt;
+                if ((res->second.size() > 0))
+                {
+                    return std::make_pair(blob_store->resolve(res->second), res.get_tranc_id());
+                }
+                else
+                {
+                    return std::nullopt;
+                }
             }
         }
     }
@@ -181,32 +308,45 @@ LSMEngine::sst_get_(const std::string &key, uint64_t tranc_id)
 
 void LSMEngine::remove(const std::string &key, uint64_t tranc_id)
 {
+    make_room_for_write();
     memtable.remove(key, tranc_id);
-    if (memtable.get_cur_size() >= LSM_TOTAL_MEM_SIZE_LIMIT)
-    {
-        // 如果memtable太大就需要刷盘
-        flush();
-    }
+
+    // 如果memtable太大就冻结，交给刷盘线程
+    maybe_freeze();
 }
 
 void LSMEngine::remove_batch(const std::vector<std::string> &keys, uint64_t tranc_id)
 {
+    make_room_for_write();
     memtable.remove_batch(keys, tranc_id);
-    if (memtable.get_cur_size() >= LSM_TOTAL_MEM_SIZE_LIMIT)
-    {
-        // 如果memtable太大就需要刷盘
-        flush();
-    }
+
+    // 如果memtable太大就冻结，交给刷盘线程
+    maybe_freeze();
 }
 
 std::string LSMEngine::get_sst_path(size_t sst_id)
 {
-    // sst的文件格式：data_dir/sst_<sst_id>
-    std::stringstream ss;
-    ss << data_dir << "/sst_" << std::setfill('0') << std::setw(4) << sst_id;
-    return ss.str();
+    return table_cache->get_sst_path(sst_id);
+}
+
+size_t LSMEngine::open_sst_count()
+{
+    return table_cache->size();
+}
+
+size_t LSMEngine::frozen_memtable_count()
+{
+    return memtable.get_frozen_count();
+}
+
+size_t LSMEngine::level_sst_count(size_t level)
+{
+    std::shared_lock<std::shared_mutex> lock(ssts_mtx);
+    auto it = level_sst_ids.find(level);
+    return it == level_sst_ids.end() ? 0 : it->second.size();
 }
 
+// 只在刷盘线程中调用(引擎析构时刷盘线程已经退出)，sst_id 的分配不需要加锁
 void LSMEngine::flush()
 {
     if (memtable.get_total_size() == 0)
@@ -214,56 +354,89 @@ void LSMEngine::flush()
         return;
     }
 
-    if (level_sst_ids.find(0) != level_sst_ids.end() &&
-        level_sst_ids[0].size() > LSM_SST_LEVEL_RATIO) {
-            // 说明已经存在了level0的sst
-            full_compact(0);
-        }
+    // compaction 在刷盘线程中进行，只在最后替换 SST 时短暂持有独占锁
+    if (level_sst_count(0) > LSM_SST_LEVEL_RATIO)
+    {
+        full_compact(0);
+    }
 
-    // 1.创建一个新的sst_id
-    size_t new_sst_id =
-      level_sst_ids[0].empty() ? 0 : level_sst_ids[0].front() + 1;
+    // 1.创建一个新的sst_id，与compact生成的sst共用一个计数器，避免id冲突
+    size_t new_sst_id = next_sst_id++;
 
     // 2.构建SST
-    SSTBuilder builder(LSM_BLOCK_MEM_LIMIT, true);
+    SSTBuilder builder(LSM_BLOCK_MEM_LIMIT, true, get_compression(0));
+    builder.set_blob_store(blob_store);
 
-    // 3.将Memtable中的最旧的一个table(skiplist)写入SST
+    // 比最老的活跃事务还旧、且被更新版本遮蔽的记录不再写入SST
+    // 没有事务管理器时无法确定哪些版本还会被读到，保留所有版本
+    uint64_t gc_tranc_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(flush_mtx);
+        if (auto manager = tran_manager.lock())
+        {
+            gc_tranc_id = manager->get_oldest_active_tranc_id();
+        }
+    }
+
+    // 3.将Memtable中所有的冻结表归并写入一个SST，减少L0中需要逐个查找的SST数量
+    // 构建期间不持有ssts_mtx
     auto path = get_sst_path(new_sst_id);
-    auto new_sst = memtable.flush_last(builder, path, new_sst_id, this->block_cache);
+    size_t flushed_count;
+    auto new_sst = memtable.flush_frozen(builder, path, new_sst_id, this->block_cache, gc_tranc_id, flushed_count);
+    if (new_sst == nullptr)
+    {
+        return;
+    }
 
-    // 4.更新内存索引
-    ssts[new_sst_id] = new_sst;
+    // 4.更新内存索引和id
+    {
+        std::unique_lock<std::shared_mutex> lock(ssts_mtx);
+        table_cache->put(new_sst);
+        sst_blob_refs[new_sst_id] = new_sst->get_blob_refs();
+        level_sst_ids[0].push_front(new_sst_id);
+    }
 
-    // 5.更新id
-    level_sst_ids[0].push_front(new_sst_id);
+    // 5.SST已经可见，再移除对应的冻结表
+    memtable.pop_last(flushed_count);
 }
 
+// 只在刷盘线程中调用，level_sst_ids 只会被这个线程修改
+// 归并和写出新 SST 时不持有 ssts_mtx，读操作继续访问旧的 SST，最后持有独占锁替换
 void LSMEngine::full_compact(size_t src_level) {
     // 先判断 compact 是否需要递归进行
-    if (level_sst_ids[src_level + 1].size() >= LSM_SST_LEVEL_RATIO) {
+    if (level_sst_count(src_level + 1) >= LSM_SST_LEVEL_RATIO) {
         full_compact(src_level + 1);
     }
 
-    auto old_level_id_x = level_sst_ids[src_level];
-    auto old_level_id_y = level_sst_ids[src_level];
+    std::vector<size_t> lx_ids;
+    std::vector<size_t> ly_ids;
+    {
+        std::shared_lock<std::shared_mutex> rlock(ssts_mtx);
+        auto it_x = level_sst_ids.find(src_level);
+        if (it_x != level_sst_ids.end()) {
+            lx_ids.assign(it_x->second.begin(), it_x->second.end());
+        }
+        auto it_y = level_sst_ids.find(src_level + 1);
+        if (it_y != level_sst_ids.end()) {
+            ly_ids.assign(it_y->second.begin(), it_y->second.end());
+        }
+    }
 
     std::vector<std::shared_ptr<SST>> new_ssts;
-    std::vector<size_t> lx_ids(old_level_id_x.begin(), old_level_id_x.end());
-    std::vector<size_t> ly_ids(old_level_id_x.begin(), old_level_id_x.end());
-
     if (src_level == 0) {
         new_ssts = full_l0_l1_compact(lx_ids, ly_ids);
     } else {
         new_ssts = full_lx_ly_compact(lx_ids, ly_ids, src_level + 1);
     }
 
-    for (auto &old_sst_id : old_level_id_x) {
-        ssts[old_sst_id]->del_sst();
-        ssts.erase(old_sst_id);
+    std::unique_lock<std::shared_mutex> wlock(ssts_mtx);
+    for (auto &old_sst_id : lx_ids) {
+        table_cache->remove(old_sst_id);
+        sst_blob_refs.erase(old_sst_id);
     }
-    for (auto &old_sst_id : old_level_id_y) {
-        ssts[old_sst_id]->del_sst();
-        ssts.erase(old_sst_id);
+    for (auto &old_sst_id : ly_ids) {
+        table_cache->remove(old_sst_id);
+        sst_blob_refs.erase(old_sst_id);
     }
     level_sst_ids[src_level].clear();
     level_sst_ids[src_level + 1].clear();
@@ -273,11 +446,35 @@ void LSMEngine::full_compact(size_t src_level) {
     for (auto &new_sst : new_ssts) {
         auto sst_id = new_sst->get_sst_id();
         level_sst_ids[src_level + 1].push_back(sst_id);
-        ssts[sst_id] = new_sst;
+        table_cache->put(new_sst);
+        sst_blob_refs[sst_id] = new_sst->get_blob_refs();
     }
 
     std::sort(level_sst_ids[src_level + 1].begin(),
                 level_sst_ids[src_level + 1].end());
+
+    // 旧的 SST 已经删除，它们独占的 blob 文件也可以删除了
+    collect_blob_garbage();
+}
+
+void LSMEngine::collect_blob_garbage() {
+    // 启动时加载的 SST 还没有记录，只读取一次文件末尾的 blob 引用统计
+    for (auto &[level, ids] : level_sst_ids) {
+        for (auto &sst_id : ids) {
+            if (sst_blob_refs.find(sst_id) == sst_blob_refs.end()) {
+                auto file = FileObj::open(get_sst_path(sst_id), false);
+                sst_blob_refs[sst_id] = SST::read_blob_refs(file);
+            }
+        }
+    }
+
+    std::unordered_map<size_t, uint64_t> live;
+    for (auto &[sst_id, refs] : sst_blob_refs) {
+        for (auto &[file_id, bytes] : refs) {
+            live[file_id] += bytes;
+        }
+    }
+    blob_store->collect_garbage(live);
 }
   
 std::vector<std::shared_ptr<SST>>
@@ -288,24 +485,30 @@ LSMEngine::full_l0_l1_compact(const std::vector<size_t> &l0_ids,
     std::vector<std::shared_ptr<SST>> l1_ssts;
 
     for (auto &sst_id : l0_ids) {
-        auto sst = ssts[sst_id];
+        auto sst = table_cache->get(sst_id);
         l0_iters.push_back(sst->begin(0));
     }
 
     for (auto &sst_id : l1_ids) {
-        auto sst = ssts[sst_id];
+        auto sst = table_cache->get(sst_id);
         l1_ssts.push_back(sst);
     }
 
     auto [l0_begin, l0_end] = SstIterator::merge_sst_iterator(l0_iters, 0);
 
+    // L1 为空时(第一次 compaction)只需要写出 L0 归并的结果
+    if (l1_ssts.empty()) {
+        return gen_ssts_from_iter(l0_begin, get_sst_size(1), 1);
+    }
+
     std::shared_ptr<HeapIterator> l0_begin_ptr = std::make_shared<HeapIterator>();
     *l0_begin_ptr = l0_begin;
 
     std::shared_ptr<ConcatIterator> old_l1_begin_ptr =
         std::make_shared<ConcatIterator>(l1_ssts, 0);
 
-    TwoMergeIterator it_begin(l0_begin_ptr, old_l1_begin_ptr, 0);
+    // 删除标记要写入新的 SST，由 gen_ssts_from_iter 决定是否丢弃
+    TwoMergeIterator it_begin(l0_begin_ptr, old_l1_begin_ptr, 0, false);
 
     return gen_ssts_from_iter(it_begin, get_sst_size(1), 1);
 }
@@ -318,30 +521,37 @@ LSMEngine::full_lx_ly_compact(const std::vector<size_t> &lx_ids,
     std::vector<std::shared_ptr<SST>> ly_ssts;
 
     for (auto &sst_id : lx_ids) {
-        auto sst = ssts[sst_id];
+        auto sst = table_cache->get(sst_id);
         lx_ssts.push_back(sst);
     }
 
     for (auto &sst_id : ly_ids) {
-        auto sst = ssts[sst_id];
+        auto sst = table_cache->get(sst_id);
         ly_ssts.push_back(sst);
     }
 
     std::shared_ptr<ConcatIterator> old_lx_begin_ptr =
         std::make_shared<ConcatIterator>(lx_ssts, 0);
 
+    // 目标层为空时直接写出 lx
+    if (ly_ssts.empty()) {
+        return gen_ssts_from_iter(*old_lx_begin_ptr, get_sst_size(y_level), y_level);
+    }
+
     std::shared_ptr<ConcatIterator> old_ly_begin_ptr =
-        std::make_shared<ConcatIterator>(lx_ssts, 0);
+        std::make_shared<ConcatIterator>(ly_ssts, 0);
 
-    TwoMergeIterator it_begin(old_lx_begin_ptr, old_ly_begin_ptr, 0);
+    TwoMergeIterator it_begin(old_lx_begin_ptr, old_ly_begin_ptr, 0, false);
 
-    return gen_ssts_from_iter(it_begin, get_sst_size(y_level), 1);
+    return gen_ssts_from_iter(it_begin, get_sst_size(y_level), y_level);
 }
 
 void LSMEngine::clear() {
+  std::unique_lock<std::shared_mutex> lock(ssts_mtx);
   memtable.clear();
   level_sst_ids.clear();
-  ssts.clear();
+  sst_blob_refs.clear();
+  table_cache->clear();
   // 清空当前文件夹的所有内容
 //   try {
 //     for (const auto &entry : std::filesystem::directory_iterator(data_dir)) {
@@ -364,26 +574,45 @@ std::vector<std::shared_ptr<SST>>
 LSMEngine::gen_ssts_from_iter(BaseIterator &iter, size_t target_sst_size,
                             size_t target_sst_level) {
     std::vector<std::shared_ptr<SST>> new_ssts;
-    auto new_sst_builder = SSTBuilder(LSM_BLOCK_MEM_LIMIT, true);
+    auto new_sst_builder = SSTBuilder(LSM_BLOCK_MEM_LIMIT, true, get_compression(target_sst_level));
+    new_sst_builder.set_blob_store(blob_store);
+
+    // 更高层没有数据时删除标记已经没有需要遮蔽的旧版本，可以丢弃
+    bool drop_tombstones = true;
+    {
+        std::shared_lock<std::shared_mutex> rlock(ssts_mtx);
+        for (auto &[level, ids] : level_sst_ids) {
+            if (level > target_sst_level && !ids.empty()) {
+                drop_tombstones = false;
+            }
+        }
+    }
 
     while (iter.is_valid() && !iter.is_end()) {
-        new_sst_builder.add((*iter).first, (*iter).second, iter.get_tranc_id());
+        auto [key, value] = *iter;
+        if (drop_tombstones && value.empty()) {
+            ++iter;
+            continue;
+        }
+        // value 保持 SST 中的存储形式，blob 引用原样写入，只有小 value 和 key 被重写
+        new_sst_builder.add_encoded(key, value, iter.get_tranc_id());
         ++iter;
 
         if (new_sst_builder.estimated_size() >= target_sst_size) {
         auto sst_id = next_sst_id++;
         std::string sst_path = get_sst_path(sst_id);
         auto new_sst =
-            new_sst_builder.build(target_sst_level, sst_path, this->block_cache);
+            new_sst_builder.build(sst_id, sst_path, this->block_cache);
         new_ssts.push_back(new_sst);
-        new_sst_builder = SSTBuilder(LSM_BLOCK_MEM_LIMIT, true);
+        new_sst_builder = SSTBuilder(LSM_BLOCK_MEM_LIMIT, true, get_compression(target_sst_level));
+        new_sst_builder.set_blob_store(blob_store);
         }
     }
     if (new_sst_builder.estimated_size() > 0) {
         auto sst_id = next_sst_id++;
         std::string sst_path = get_sst_path(sst_id);
         auto new_sst =
-            new_sst_builder.build(target_sst_level, sst_path, this->block_cache);
+            new_sst_builder.build(sst_id, sst_path, this->block_cache);
         new_ssts.push_back(new_sst);
     }
 
@@ -398,27 +627,39 @@ size_t LSMEngine::get_sst_size(const size_t &level) {
     return sst_size;
 }
 
+CompressionType LSMEngine::get_compression(size_t level) {
+    return level >= LSM_COMPRESSION_MIN_LEVEL ? CompressionType::LZ : CompressionType::None;
+}
+
 // ****************LSM***********************
 
 LSM::LSM(std::string path) : engine_(std::make_shared<LSMEngine>(path)),
      tran_(std::make_shared<TranManager>(path, IsolationLevel::ReadCommitted))
 {
     tran_->set_engine(engine_);
+    engine_->set_tran_manager(tran_);
     std::map<uint64_t, std::vector<Record>> check_recover_res = tran_->check_recover();
 
     for(auto &[tranc_id, records] : check_recover_res)
     {
+        // 同一个事务的操作合并为一次批量写入，删除即写入空的 value
+        // 批量写入对相同的 key 保持原有顺序，后面的操作覆盖前面的
+        std::vector<std::pair<std::string, std::string>> kvs;
         for(auto &record : records)
         {
             if(record.op_type_ == OperationType::Put)
             {
-                engine_->put(record.key_, record.value_, tranc_id);
+                kvs.emplace_back(record.key_, record.value_);
             }
             else if(record.op_type_ == OperationType::Delete)
             {
-                engine_->remove(record.key_, tranc_id);
+                kvs.emplace_back(record.key_, "");
             }
         }
+        if(!kvs.empty())
+        {
+            engine_->put_batch(kvs, tranc_id);
+        }
     }
     tran_->init_new_wal();
 }
@@ -8,11 +8,25 @@
 
 TranContext::TranContext(uint64_t tranc_id, std::shared_ptr<LSMEngine> engine,
                          std::shared_ptr<TranManager> manager, const enum IsolationLevel isolation_level)
-    : tranc_id_(tranc_id), engine_(engine), manager_(manager)
+    : tranc_id_(tranc_id), engine_(engine), manager_(manager), isolation_level_(isolation_level)
 {
     operations_.emplace_back(Record::createRecord(tranc_id_));
 }
 
+TranContext::~TranContext()
+{
+    finish();
+}
+
+void TranContext::finish()
+{
+    if (!finished_)
+    {
+        finished_ = true;
+        manager_->finish_tranc(tranc_id_);
+    }
+}
+
 void TranContext::put(const std::string &key, const std::string &value)
 {
     // 无论是什么隔离级别，都需要先插入操作记录到opertional_
@@ -121,6 +135,7 @@ bool TranContext::commit()
 
         manager_->update_max_finished_tranc_id(tranc_id_);
 
+        finish();
         return true;
     }
 
@@ -142,6 +157,7 @@ bool TranContext::commit()
                 operations_.emplace_back(Record::rollbackRecord(tranc_id_)); // 添加回滚记录到操作列表
                 // TODO: 需要刷入WAL的回滚标记（异步刷入的情况）
 
+                finish();
                 return false; // 返回提交失败，触发回滚
             }
             else
@@ -160,6 +176,7 @@ bool TranContext::commit()
                         operations_.emplace_back(Record::rollbackRecord(tranc_id_));
                         // TODO: 需要刷入WAL的回滚标记（异步刷入的情况）
 
+                        finish();
                         return false; // 返回提交失败，触发回滚
                     }
                 }
@@ -177,6 +194,7 @@ bool TranContext::commit()
 
     manager_->update_max_finished_tranc_id(this->tranc_id_);
 
+    finish();
     return true;
 }
 
@@ -199,11 +217,13 @@ bool TranContext::abort() // 事务的终止功能
         }
     }
 
+    finish();
     return true;
 }
 
 TranManager::TranManager(std::string data_dir,
                          enum IsolationLevel isolation_level)
+    : data_dir_(std::move(data_dir))
 {
     auto tranc_id_file_path = get_tranc_id_file_path();
     // 判断文件是否存在
@@ -229,7 +249,7 @@ void TranManager::TranManager::set_engine(std::shared_ptr<LSMEngine> engine) {
 
 std::string TranManager::get_tranc_id_file_path()
 {
-    if (!data_dir_.empty())
+    if (data_dir_.empty())
     {
         data_dir_ = "./";
     }
@@ -266,11 +286,28 @@ std::shared_ptr<TranContext> TranManager::new_tranc(const enum IsolationLevel &i
     std::unique_lock<std::mutex> lock(mutex_);
 
     auto tranc_id = get_next_tranc_id();
+    active_trancs_.insert(tranc_id);
     auto context =
         std::make_shared<TranContext>(tranc_id, engine_, shared_from_this(), isolation_level);
     return context;
 }
 
+void TranManager::finish_tranc(uint64_t tranc_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    active_trancs_.erase(tranc_id);
+}
+
+uint64_t TranManager::get_oldest_active_tranc_id()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (active_trancs_.empty())
+    {
+        return next_tranc_id_;
+    }
+    return *active_trancs_.begin();
+}
+
 uint64_t TranManager::get_max_flushed_tranc_id()
 {
     return max_flushed_tranc_id_;
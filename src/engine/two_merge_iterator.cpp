@@ -3,11 +3,11 @@
 
 TwoMergeIterator::TwoMergeIterator(uint64_t max_tranc_id) : max_tranc_id_(max_tranc_id) {}
 
-TwoMergeIterator::TwoMergeIterator(std::shared_ptr<BaseIterator> a, std::shared_ptr<BaseIterator> b, uint64_t max_tranc_id)
-    : max_tranc_id_(max_tranc_id), it_a(std::move(a)), it_b(move(b))
+TwoMergeIterator::TwoMergeIterator(std::shared_ptr<BaseIterator> a, std::shared_ptr<BaseIterator> b, uint64_t max_tranc_id,
+                                   bool skip_delete)
+    : max_tranc_id_(max_tranc_id), skip_delete_(skip_delete), it_a(std::move(a)), it_b(move(b))
 {
-    skip_it_b();
-    choose_a = choose_it_a();
+    seek_visible();
 }
 
 // 是否选择迭代器it_a
@@ -29,8 +29,8 @@ bool TwoMergeIterator::choose_it_a()
 
 void TwoMergeIterator::skip_it_b()
 {
-    // it_b未到末尾但无效，it_a 的键值小于 it_b 的键值。
-    if (!it_b->is_end() && !it_b->is_valid() && (**it_a).first < (**it_b).first)
+    // 跳过 it_b 中与 it_a 当前 key 相同的记录，it_a 的版本更新
+    while (!it_a->is_end() && !it_b->is_end() && it_b->is_valid() && (**it_a).first == (**it_b).first)
     {
         ++(*it_b); // 递增it_b
     }
@@ -51,9 +51,29 @@ BaseIterator &TwoMergeIterator::operator++()
     {
         ++(*it_b);
     }
+    seek_visible();
+    return *this;
+}
+
+void TwoMergeIterator::seek_visible()
+{
     skip_it_b(); // 跳过重复的key，选择优先级更高的it_a
     choose_a = choose_it_a();
-    return *this;
+
+    // it_a 中的删除标记已经屏蔽了 it_b 中相同 key 的旧记录，本身不对外输出
+    while (skip_delete_ && !is_end() && (choose_a ? (**it_a).second : (**it_b).second).empty())
+    {
+        if (choose_a)
+        {
+            ++(*it_a);
+        }
+        else
+        {
+            ++(*it_b);
+        }
+        skip_it_b();
+        choose_a = choose_it_a();
+    }
 }
 
 bool TwoMergeIterator::operator==(const BaseIterator &other) const
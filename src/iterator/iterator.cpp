@@ -36,8 +36,8 @@ bool operator==(const SearchItem &a, const SearchItem &b) {
 
 // *************************** HeapIterator ***************************
 HeapIterator::HeapIterator(std::vector<SearchItem> item_vec,
-                           uint64_t max_tranc_id)
-    : max_tranc_id_(max_tranc_id) {
+                           uint64_t max_tranc_id, bool skip_delete)
+    : max_tranc_id_(max_tranc_id), skip_delete_(skip_delete) {
   for (auto &item : item_vec) {
 
     items.push(item);
@@ -125,12 +125,12 @@ bool HeapIterator::top_value_legal() const {
   if (max_tranc_id_ == 0) {
     // 没有开启事务
     // 不为空的 value 才合法
-    return items.top().value_.size() > 0;
+    return !skip_delete_ || items.top().value_.size() > 0;
   }
 
   if (items.top().tranc_id_ <= max_tranc_id_) {
     // 事务id可见, 则判断其value是否为空
-    return items.top().value_.size() > 0;
+    return !skip_delete_ || items.top().value_.size() > 0;
   } else {
     // 事务id不可见, 即不合法
     return false;
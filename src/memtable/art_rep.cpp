@@ -0,0 +1,514 @@
+#include "../../include/memtable/art_rep.h"
+#include "../../include/memtable/version_chain.h"
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// 子节点指针的最低位为 1 表示叶子(版本链表头)，否则是内部节点
+// SkipListNode 和内部节点都按 8 字节对齐，最低位一定为 0
+static inline bool is_leaf(const void *ptr)
+{
+    return reinterpret_cast<uintptr_t>(ptr) & 1;
+}
+
+static inline SkipListNode *as_leaf(const void *ptr)
+{
+    return reinterpret_cast<SkipListNode *>(reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(1));
+}
+
+static inline void *tag_leaf(SkipListNode *node)
+{
+    return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(node) | 1);
+}
+
+enum ArtNodeType : uint8_t
+{
+    ART_NODE4,
+    ART_NODE16,
+    ART_NODE48,
+    ART_NODE256,
+};
+
+struct ArtNode
+{
+    ArtNodeType type;
+    uint16_t num_children;
+    uint32_t prefix_len; // 压缩的路径长度
+    const char *prefix;  // 压缩的路径，指向 arena 中某个 key 的字节
+    void *end_leaf;      // 恰好在这个节点结束的 key，它比所有子节点的 key 都小
+};
+
+// Node4 / Node16：keys 有序排列，与 children 一一对应
+struct ArtNode4 : ArtNode
+{
+    uint8_t keys[4];
+    void *children[4];
+};
+
+struct ArtNode16 : ArtNode
+{
+    uint8_t keys[16];
+    void *children[16];
+};
+
+// Node48：child_index[字节] 为子节点在 children 中的下标加一，0 表示不存在
+struct ArtNode48 : ArtNode
+{
+    uint8_t child_index[256];
+    void *children[48];
+};
+
+// Node256：直接按字节索引
+struct ArtNode256 : ArtNode
+{
+    void *children[256];
+};
+
+template <typename T>
+static T *alloc_node(Arena &arena, ArtNodeType type)
+{
+    char *mem = arena.allocate(sizeof(T));
+    memset(mem, 0, sizeof(T));
+    T *node = new (mem) T;
+    node->type = type;
+    return node;
+}
+
+static void copy_header(ArtNode *dst, const ArtNode *src)
+{
+    dst->num_children = src->num_children;
+    dst->prefix_len = src->prefix_len;
+    dst->prefix = src->prefix;
+    dst->end_leaf = src->end_leaf;
+}
+
+// 查找字节 b 对应的子节点槽位，不存在时返回 nullptr
+static void **find_child(ArtNode *node, uint8_t b)
+{
+    switch (node->type)
+    {
+    case ART_NODE4:
+    {
+        auto n = static_cast<ArtNode4 *>(node);
+        for (int i = 0; i < n->num_children; i++)
+        {
+            if (n->keys[i] == b)
+            {
+                return &n->children[i];
+            }
+        }
+        return nullptr;
+    }
+    case ART_NODE16:
+    {
+        auto n = static_cast<ArtNode16 *>(node);
+#ifdef __SSE2__
+        // 一次比较全部 16 个字节
+        __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(b)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(n->keys)));
+        int mask = _mm_movemask_epi8(cmp) & ((1 << n->num_children) - 1);
+        return mask ? &n->children[__builtin_ctz(mask)] : nullptr;
+#else
+        for (int i = 0; i < n->num_children; i++)
+        {
+            if (n->keys[i] == b)
+            {
+                return &n->children[i];
+            }
+        }
+        return nullptr;
+#endif
+    }
+    case ART_NODE48:
+    {
+        auto n = static_cast<ArtNode48 *>(node);
+        return n->child_index[b] ? &n->children[n->child_index[b] - 1] : nullptr;
+    }
+    case ART_NODE256:
+    {
+        auto n = static_cast<ArtNode256 *>(node);
+        return n->children[b] ? &n->children[b] : nullptr;
+    }
+    }
+    return nullptr;
+}
+
+// 在 *ref 指向的节点中为字节 b 新增一个空槽位并返回
+// 节点已满时换成更大的节点，并更新 *ref
+static void **add_child(Arena &arena, void **ref, uint8_t b)
+{
+    auto node = static_cast<ArtNode *>(*ref);
+    switch (node->type)
+    {
+    case ART_NODE4:
+    {
+        auto n = static_cast<ArtNode4 *>(node);
+        if (n->num_children < 4)
+        {
+            int pos = 0;
+            while (pos < n->num_children && n->keys[pos] < b)
+            {
+                pos++;
+            }
+            memmove(n->keys + pos + 1, n->keys + pos, n->num_children - pos);
+            memmove(n->children + pos + 1, n->children + pos, (n->num_children - pos) * sizeof(void *));
+            n->keys[pos] = b;
+            n->children[pos] = nullptr;
+            n->num_children++;
+            return &n->children[pos];
+        }
+        auto bigger = alloc_node<ArtNode16>(arena, ART_NODE16);
+        copy_header(bigger, n);
+        memcpy(bigger->keys, n->keys, sizeof(n->keys));
+        memcpy(bigger->children, n->children, sizeof(n->children));
+        *ref = bigger;
+        return add_child(arena, ref, b);
+    }
+    case ART_NODE16:
+    {
+        auto n = static_cast<ArtNode16 *>(node);
+        if (n->num_children < 16)
+        {
+            int pos = 0;
+            while (pos < n->num_children && n->keys[pos] < b)
+            {
+                pos++;
+            }
+            memmove(n->keys + pos + 1, n->keys + pos, n->num_children - pos);
+            memmove(n->children + pos + 1, n->children + pos, (n->num_children - pos) * sizeof(void *));
+            n->keys[pos] = b;
+            n->children[pos] = nullptr;
+            n->num_children++;
+            return &n->children[pos];
+        }
+        auto bigger = alloc_node<ArtNode48>(arena, ART_NODE48);
+        copy_header(bigger, n);
+        for (int i = 0; i < 16; i++)
+        {
+            bigger->child_index[n->keys[i]] = i + 1;
+            bigger->children[i] = n->children[i];
+        }
+        *ref = bigger;
+        return add_child(arena, ref, b);
+    }
+    case ART_NODE48:
+    {
+        auto n = static_cast<ArtNode48 *>(node);
+        if (n->num_children < 48)
+        {
+            // 子节点不会被删除，children 的前 num_children 个位置都已占用
+            int pos = n->num_children++;
+            n->child_index[b] = pos + 1;
+            n->children[pos] = nullptr;
+            return &n->children[pos];
+        }
+        auto bigger = alloc_node<ArtNode256>(arena, ART_NODE256);
+        copy_header(bigger, n);
+        for (int c = 0; c < 256; c++)
+        {
+            if (n->child_index[c])
+            {
+                bigger->children[c] = n->children[n->child_index[c] - 1];
+            }
+        }
+        *ref = bigger;
+        return add_child(arena, ref, b);
+    }
+    case ART_NODE256:
+    {
+        auto n = static_cast<ArtNode256 *>(node);
+        n->num_children++;
+        return &n->children[b];
+    }
+    }
+    return nullptr;
+}
+
+// 按 key 的字典序把所有记录追加到 snapshot
+static void collect(const void *ptr, SkipListIterator::Snapshot &snapshot)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    if (is_leaf(ptr))
+    {
+        chain_collect(as_leaf(ptr), snapshot);
+        return;
+    }
+
+    auto node = static_cast<const ArtNode *>(ptr);
+    collect(node->end_leaf, snapshot);
+    switch (node->type)
+    {
+    case ART_NODE4:
+    {
+        auto n = static_cast<const ArtNode4 *>(node);
+        for (int i = 0; i < n->num_children; i++)
+        {
+            collect(n->children[i], snapshot);
+        }
+        break;
+    }
+    case ART_NODE16:
+    {
+        auto n = static_cast<const ArtNode16 *>(node);
+        for (int i = 0; i < n->num_children; i++)
+        {
+            collect(n->children[i], snapshot);
+        }
+        break;
+    }
+    case ART_NODE48:
+    {
+        auto n = static_cast<const ArtNode48 *>(node);
+        for (int c = 0; c < 256; c++)
+        {
+            if (n->child_index[c])
+            {
+                collect(n->children[n->child_index[c] - 1], snapshot);
+            }
+        }
+        break;
+    }
+    case ART_NODE256:
+    {
+        auto n = static_cast<const ArtNode256 *>(node);
+        for (int c = 0; c < 256; c++)
+        {
+            collect(n->children[c], snapshot);
+        }
+        break;
+    }
+    }
+}
+
+/*********************** ArtRep *******************/
+
+ArtRep::ArtRep() : arena(std::make_shared<Arena>()) {}
+
+void **ArtRep::leaf_slot(std::string_view key)
+{
+    void **ref = &root;
+    size_t depth = 0;
+    while (true)
+    {
+        void *current = *ref;
+        if (current == nullptr)
+        {
+            return ref;
+        }
+
+        if (is_leaf(current))
+        {
+            std::string_view leaf_key = as_leaf(current)->key();
+            if (leaf_key == key)
+            {
+                return ref;
+            }
+
+            // 两个 key 在 depth 之前相同，用一个 Node4 保存从 depth 开始的公共部分，再把两者挂在它下面
+            size_t common = depth;
+            while (common < leaf_key.size() && common < key.size() && leaf_key[common] == key[common])
+            {
+                common++;
+            }
+            auto node = alloc_node<ArtNode4>(*arena, ART_NODE4);
+            node->prefix = leaf_key.data() + depth;
+            node->prefix_len = common - depth;
+            *ref = node;
+            if (common == leaf_key.size())
+            {
+                node->end_leaf = current;
+            }
+            else
+            {
+                *add_child(*arena, ref, static_cast<uint8_t>(leaf_key[common])) = current;
+            }
+            continue; // 新节点的前缀一定匹配，重新进入循环处理 key
+        }
+
+        auto node = static_cast<ArtNode *>(current);
+        size_t matched = 0;
+        while (matched < node->prefix_len && depth + matched < key.size() && node->prefix[matched] == key[depth + matched])
+        {
+            matched++;
+        }
+        if (matched < node->prefix_len)
+        {
+            // 前缀只匹配了一部分：在匹配的位置拆分，原节点保留剩余的前缀
+            auto parent = alloc_node<ArtNode4>(*arena, ART_NODE4);
+            parent->prefix = node->prefix;
+            parent->prefix_len = matched;
+            uint8_t b = static_cast<uint8_t>(node->prefix[matched]);
+            node->prefix += matched + 1;
+            node->prefix_len -= matched + 1;
+            *ref = parent;
+            *add_child(*arena, ref, b) = node;
+            continue;
+        }
+
+        depth += node->prefix_len;
+        if (depth == key.size())
+        {
+            return &node->end_leaf;
+        }
+        uint8_t b = static_cast<uint8_t>(key[depth]);
+        void **child = find_child(node, b);
+        if (child == nullptr)
+        {
+            return add_child(*arena, ref, b);
+        }
+        ref = child;
+        depth++;
+    }
+}
+
+SkipListNode *ArtRep::find_leaf(std::string_view key) const
+{
+    const void *current = root;
+    size_t depth = 0;
+    while (current != nullptr)
+    {
+        if (is_leaf(current))
+        {
+            // 路径上只比较了部分字节，叶子需要完整比较一次
+            SkipListNode *leaf = as_leaf(current);
+            return leaf->key() == key ? leaf : nullptr;
+        }
+
+        auto node = static_cast<ArtNode *>(const_cast<void *>(current));
+        if (node->prefix_len > key.size() - depth || memcmp(node->prefix, key.data() + depth, node->prefix_len) != 0)
+        {
+            return nullptr;
+        }
+        depth += node->prefix_len;
+        if (depth == key.size())
+        {
+            current = node->end_leaf;
+            continue;
+        }
+        void **child = find_child(node, static_cast<uint8_t>(key[depth]));
+        current = child ? *child : nullptr;
+        depth++;
+    }
+    return nullptr;
+}
+
+void ArtRep::put(std::string_view key, std::string_view value, uint64_t tranc_id)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    put_(key, value, tranc_id);
+}
+
+void ArtRep::put_batch(std::vector<std::pair<std::string_view, std::string_view>> kvs, uint64_t tranc_id)
+{
+    // 整批只加一次锁，按原来的顺序写入，后写入的覆盖先写入的
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    for (auto &[key, value] : kvs)
+    {
+        put_(key, value, tranc_id);
+    }
+}
+
+void ArtRep::put_(std::string_view key, std::string_view value, uint64_t tranc_id)
+{
+    void **slot = leaf_slot(key);
+    SkipListNode *head = *slot ? as_leaf(*slot) : nullptr;
+    bool inserted;
+    size_bytes += chain_put(head, *arena, key, value, tranc_id, inserted);
+    *slot = tag_leaf(head);
+
+    if (inserted)
+    {
+        // 插入了新记录，有序快照需要重新生成
+        std::lock_guard<std::mutex> sorted_lock(sorted_mtx);
+        sorted.reset();
+    }
+}
+
+SkipListIterator ArtRep::get(std::string_view key, uint64_t tranc_id)
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return get_(key, tranc_id);
+}
+
+std::vector<SkipListIterator> ArtRep::get_batch(const std::vector<std::string_view> &keys, uint64_t tranc_id)
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    std::vector<SkipListIterator> results;
+    results.reserve(keys.size());
+    for (auto &key : keys)
+    {
+        results.push_back(get_(key, tranc_id));
+    }
+    return results;
+}
+
+SkipListIterator ArtRep::get_(std::string_view key, uint64_t tranc_id) const
+{
+    SkipListNode *node = chain_get(find_leaf(key), tranc_id);
+    if (node == nullptr)
+    {
+        return SkipListIterator(nullptr);
+    }
+    return SkipListIterator(node, arena);
+}
+
+void ArtRep::remove(std::string_view key)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    size_bytes -= chain_remove(find_leaf(key));
+}
+
+void ArtRep::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    root = nullptr;
+    arena = std::make_shared<Arena>();
+    size_bytes = 0;
+    std::lock_guard<std::mutex> sorted_lock(sorted_mtx);
+    sorted.reset();
+}
+
+std::shared_ptr<const SkipListIterator::Snapshot> ArtRep::get_sorted()
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    std::lock_guard<std::mutex> sorted_lock(sorted_mtx);
+    if (!sorted)
+    {
+        // 中序遍历即为 key 的字典序，不需要排序
+        auto snapshot = std::make_shared<SkipListIterator::Snapshot>();
+        collect(root, *snapshot);
+        sorted = snapshot;
+    }
+    return sorted;
+}
+
+SkipListIterator ArtRep::begin()
+{
+    return SkipListIterator(get_sorted(), 0, arena);
+}
+
+SkipListIterator ArtRep::end()
+{
+    return SkipListIterator(nullptr);
+}
+
+std::optional<std::pair<SkipListIterator, SkipListIterator>> ArtRep::iters_monotony_predicate(std::function<int(const std::string &)> predicate)
+{
+    return snapshot_predicate_range(get_sorted(), arena, predicate);
+}
+
+size_t ArtRep::get_size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return size_bytes;
+}
+
+size_t ArtRep::get_memory_usage() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return arena->get_memory_usage();
+}
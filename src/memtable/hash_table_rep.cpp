@@ -0,0 +1,156 @@
+#include "../../include/memtable/hash_table_rep.h"
+#include "../../include/memtable/version_chain.h"
+#include <algorithm>
+
+HashTableRep::HashTableRep() : arena(std::make_shared<Arena>()) {}
+
+void HashTableRep::put(std::string_view key, std::string_view value, uint64_t tranc_id)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    put_(key, value, tranc_id);
+}
+
+void HashTableRep::put_batch(std::vector<std::pair<std::string_view, std::string_view>> kvs, uint64_t tranc_id)
+{
+    // 整批只加一次锁，按原来的顺序写入，后写入的覆盖先写入的
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    for (auto &[key, value] : kvs)
+    {
+        put_(key, value, tranc_id);
+    }
+}
+
+void HashTableRep::put_(std::string_view key, std::string_view value, uint64_t tranc_id)
+{
+    bool inserted;
+    auto it = table.find(key);
+    if (it == table.end())
+    {
+        // 新 key：哈希表的 key 直接引用节点在 arena 中的 key
+        SkipListNode *head = nullptr;
+        size_bytes += chain_put(head, *arena, key, value, tranc_id, inserted);
+        table.emplace(head->key(), head);
+    }
+    else
+    {
+        size_bytes += chain_put(it->second, *arena, key, value, tranc_id, inserted);
+    }
+
+    if (inserted)
+    {
+        // 插入了新记录，有序快照需要重新生成
+        std::lock_guard<std::mutex> sorted_lock(sorted_mtx);
+        sorted.reset();
+    }
+}
+
+SkipListIterator HashTableRep::get(std::string_view key, uint64_t tranc_id)
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return get_(key, tranc_id);
+}
+
+std::vector<SkipListIterator> HashTableRep::get_batch(const std::vector<std::string_view> &keys, uint64_t tranc_id)
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    std::vector<SkipListIterator> results;
+    results.reserve(keys.size());
+    for (auto &key : keys)
+    {
+        results.push_back(get_(key, tranc_id));
+    }
+    return results;
+}
+
+SkipListIterator HashTableRep::get_(std::string_view key, uint64_t tranc_id) const
+{
+    auto it = table.find(key);
+    if (it == table.end())
+    {
+        return SkipListIterator(nullptr);
+    }
+    SkipListNode *node = chain_get(it->second, tranc_id);
+    if (node == nullptr)
+    {
+        return SkipListIterator(nullptr);
+    }
+    return SkipListIterator(node, arena);
+}
+
+void HashTableRep::remove(std::string_view key)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    auto it = table.find(key);
+    if (it != table.end())
+    {
+        size_bytes -= chain_remove(it->second);
+    }
+}
+
+void HashTableRep::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    table.clear();
+    arena = std::make_shared<Arena>();
+    size_bytes = 0;
+    std::lock_guard<std::mutex> sorted_lock(sorted_mtx);
+    sorted.reset();
+}
+
+std::shared_ptr<const SkipListIterator::Snapshot> HashTableRep::get_sorted()
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    std::lock_guard<std::mutex> sorted_lock(sorted_mtx);
+    if (sorted)
+    {
+        return sorted;
+    }
+
+    // 先对链表头按 key 排序，再展开每条链表，链表内已经按事务 id 从大到小排列
+    std::vector<const SkipListNode *> heads;
+    heads.reserve(table.size());
+    for (auto &[key, head] : table)
+    {
+        heads.push_back(head);
+    }
+    std::sort(heads.begin(), heads.end(), [](const SkipListNode *a, const SkipListNode *b)
+              { return a->key() < b->key(); });
+
+    auto snapshot = std::make_shared<SkipListIterator::Snapshot>();
+    snapshot->reserve(heads.size());
+    for (auto head : heads)
+    {
+        chain_collect(head, *snapshot);
+    }
+    sorted = snapshot;
+    return sorted;
+}
+
+SkipListIterator HashTableRep::begin()
+{
+    return SkipListIterator(get_sorted(), 0, arena);
+}
+
+SkipListIterator HashTableRep::end()
+{
+    return SkipListIterator(nullptr);
+}
+
+std::optional<std::pair<SkipListIterator, SkipListIterator>> HashTableRep::iters_monotony_predicate(std::function<int(const std::string &)> predicate)
+{
+    return snapshot_predicate_range(get_sorted(), arena, predicate);
+}
+
+size_t HashTableRep::get_size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return size_bytes;
+}
+
+size_t HashTableRep::get_memory_usage() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    // 节点都在 arena 中，哈希表自身按桶数组和每个元素一个链表节点估算
+    return arena->get_memory_usage() + table.bucket_count() * sizeof(void *) +
+           table.size() * (sizeof(std::string_view) + sizeof(SkipListNode *) + 2 * sizeof(void *));
+}
@@ -1,14 +1,17 @@
 #include "../../include/memtable/memtable.h"
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
 
-Memtable::Memtable() : current_table(std::make_shared<SkipList>()), frozen_bytes(0) {}
+Memtable::Memtable(MemTableRepType rep_type, size_t size_limit)
+    : rep_type(rep_type), size_limit(size_limit), current_table(new_memtable_rep(rep_type, size_limit)), frozen_bytes(0) {}
 
 void Memtable::put(const std::string &key, const std::string &value, uint64_t tranc_id)
 {
-    std::unique_lock<std::shared_mutex> lock(cur_mtx);
+    // 跳表本身支持并发写入，这里只需要防止 current_table 被冻结替换
+    std::shared_lock<std::shared_mutex> lock(cur_mtx);
     // current_table->put(key, value);
     put_(key, value, tranc_id);
 }
@@ -20,16 +23,20 @@ void Memtable::put_(const std::string &key, const std::string &value, uint64_t t
 
 void Memtable::put_batch(const std::vector<std::pair<std::string, std::string>> &kvs, uint64_t tranc_id)
 {
-    std::unique_lock<std::shared_mutex> lock(cur_mtx);
-    for (size_t i = 0; i < kvs.size(); i++)
+    std::vector<std::pair<std::string_view, std::string_view>> views;
+    views.reserve(kvs.size());
+    for (auto &[key, value] : kvs)
     {
-        put_(kvs[i].first, kvs[i].second, tranc_id);
+        views.emplace_back(key, value);
     }
+
+    std::shared_lock<std::shared_mutex> lock(cur_mtx);
+    current_table->put_batch(std::move(views), tranc_id);
 }
 
 void Memtable::remove(const std::string &key, uint64_t tranc_id)
 {
-    std::unique_lock<std::shared_mutex> lock(cur_mtx);
+    std::shared_lock<std::shared_mutex> lock(cur_mtx);
     // current_table->put(key, "");
     remove_(key, tranc_id);
 }
@@ -41,11 +48,16 @@ void Memtable::remove_(const std::string &key, uint64_t tranc_id)
 
 void Memtable::remove_batch(const std::vector<std::string> &keys, uint64_t tranc_id)
 {
-    std::unique_lock<std::shared_mutex> lock(cur_mtx);
-    for (const auto &key : keys)
+    // 删除即写入空的 value
+    std::vector<std::pair<std::string_view, std::string_view>> views;
+    views.reserve(keys.size());
+    for (auto &key : keys)
     {
-        remove_(key, tranc_id);
+        views.emplace_back(key, std::string_view());
     }
+
+    std::shared_lock<std::shared_mutex> lock(cur_mtx);
+    current_table->put_batch(std::move(views), tranc_id);
 }
 
 void Memtable::clear()
@@ -58,52 +70,39 @@ void Memtable::clear()
 }
 
 // 谓词查询
-std::optional<std::pair<HeapIterator, HeapIterator>> Memtable::iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate)
+std::optional<std::pair<MemMergeIterator, MemMergeIterator>> Memtable::iter_monotony_predicate(uint64_t tranc_id, std::function<int(const std::string &)> predicate,
+                                                                                                     bool skip_delete)
 {
-    // 汇总每个skiplist谓词查询的结果
+    // 汇总每个skiplist谓词查询的结果区间，由 MemMergeIterator 按需合并
 
-    // 加锁，并发读取
+    // 加锁，并发读取，只在收集各个跳表的区间时持有
     std::shared_lock<std::shared_mutex> lock1(frozen_mtx);
     std::shared_lock<std::shared_mutex> lock2(cur_mtx);
 
-    std::vector<SearchItem> item_vec; // 存储满足谓词条件的查询结果。每个结果是一个SearchItem对象，包含键、值以及表的索引。
+    std::vector<std::pair<SkipListIterator, SkipListIterator>> ranges;
 
-    // 对活跃表的执行谓词查询
+    // 活跃表最新，排在最前面
     auto cur_result = current_table->iters_monotony_predicate(predicate);
     if (cur_result.has_value())
     {
-        auto [cur_begin, cur_end] = cur_result.value();
-        for (auto iter = cur_begin; iter != cur_end; ++iter) // 遍历迭代器范围
-        {
-            if (tranc_id != 0 && iter.get_tranc_id() == tranc_id > tranc_id)
-            {
-                continue;
-            }
-            item_vec.emplace_back(iter.get_key(), iter.get_value(), 0, 0, iter.get_tranc_id());
-        }
+        ranges.push_back(cur_result.value());
     }
 
-    int table_idx = 1;
-    for (auto ft = frozen_tables.begin(); ft != frozen_tables.end(); ft++) // 遍历frozen_tables中的每个冻结表
+    for (auto &table : frozen_tables) // 遍历frozen_tables中的每个冻结表，从新到旧
     {
-        auto table = *ft;
         auto result = table->iters_monotony_predicate(predicate);
         if (result.has_value())
         {
-            auto [begin, end] = result.value();
-            for (auto iter = begin; iter != end; ++iter)
-            {
-                if (tranc_id != 0 && iter.get_tranc_id() == tranc_id > tranc_id)
-                {
-                    continue;
-                }
-                item_vec.emplace_back(iter.get_key(), iter.get_value(), table_idx, 0, iter.get_tranc_id());
-            }
+            ranges.push_back(result.value());
         }
-        table_idx++;
     }
 
-    return std::make_pair(HeapIterator(item_vec, tranc_id), HeapIterator());
+    MemMergeIterator it_begin(std::move(ranges), tranc_id, skip_delete);
+    if (it_begin.is_end())
+    {
+        return std::nullopt;
+    }
+    return std::make_pair(it_begin, MemMergeIterator());
 }
 
 SkipListIterator Memtable::get(const std::string &key, uint64_t tranc_id)
@@ -133,20 +132,56 @@ std::vector<SkipListIterator> Memtable::get_batch(const std::vector<std::string>
     std::shared_lock<std::shared_mutex> lock1(frozen_mtx);
     std::shared_lock<std::shared_mutex> lock2(cur_mtx);
 
-    std::vector<SkipListIterator> results;
+    std::vector<SkipListIterator> results(keys.size(), SkipListIterator{nullptr});
 
-    for (const auto &key : keys)
+    // 依次在活跃表和冻结表(从新到旧)中查找，每张表只查找还没有找到、且可能在表中的 key
+    std::vector<size_t> pending(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
     {
+        pending[i] = i;
+    }
 
-        auto result1 = cur_get_(key, tranc_id);
-        if (result1.is_valid())
+    auto lookup = [&](const std::shared_ptr<MemTableRep> &table)
+    {
+        std::vector<size_t> candidates;
+        std::vector<std::string_view> candidate_keys;
+        std::vector<size_t> rest;
+        for (size_t idx : pending)
         {
-            results.push_back(result1);
-            continue;
+            if (table->may_contain(keys[idx]))
+            {
+                candidates.push_back(idx);
+                candidate_keys.push_back(keys[idx]);
+            }
+            else
+            {
+                rest.push_back(idx);
+            }
+        }
+
+        auto found = table->get_batch(candidate_keys, tranc_id);
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (found[i].is_valid())
+            {
+                results[candidates[i]] = std::move(found[i]);
+            }
+            else
+            {
+                rest.push_back(candidates[i]);
+            }
         }
+        pending = std::move(rest);
+    };
 
-        auto result2 = frozen_get_(key, tranc_id);
-        results.push_back(result2);
+    lookup(current_table);
+    for (auto &table : frozen_tables)
+    {
+        if (pending.empty())
+        {
+            break;
+        }
+        lookup(table);
     }
 
     return results;
@@ -154,6 +189,10 @@ std::vector<SkipListIterator> Memtable::get_batch(const std::vector<std::string>
 
 SkipListIterator Memtable::cur_get_(const std::string &key, uint64_t tranc_id)
 {
+    if (!current_table->may_contain(key))
+    {
+        return SkipListIterator{nullptr};
+    }
     auto res = current_table->get(key, tranc_id);
     if (res.is_valid())
     {
@@ -167,6 +206,11 @@ SkipListIterator Memtable::frozen_get_(const std::string &key, uint64_t tranc_id
     // 查冻结的表
     for (auto &table : frozen_tables)
     {
+        // 布隆过滤器判断 key 不存在时跳过这张表，不需要在跳表中查找
+        if (!table->may_contain(key))
+        {
+            continue;
+        }
         auto res = table->get(key, tranc_id);
         if (res.is_valid())
             return res;
@@ -200,74 +244,148 @@ void Memtable::frozen_cur_table_()
 {
     frozen_bytes += current_table->get_size();
     frozen_tables.push_front(std::move(current_table)); // 最近插入的表插入队头
-    current_table = std::make_shared<SkipList>();
+    current_table = new_memtable_rep(rep_type, size_limit);
 }
-std::shared_ptr<SST> Memtable::flush_last(SSTBuilder &builder, std::string &sst_path, size_t sst_id, std::shared_ptr<BlockCache> block_cache)
+std::shared_ptr<SST> Memtable::flush_frozen(SSTBuilder &builder, std::string &sst_path, size_t sst_id, std::shared_ptr<BlockCache> block_cache,
+                                            uint64_t gc_tranc_id, size_t &flushed_count)
 {
-    std::unique_lock<std::shared_mutex> lock1(frozen_mtx);
-    if (frozen_tables.empty())
+    std::vector<std::shared_ptr<MemTableRep>> tables; // 最新的表在前
     {
-        // 如果为空，将活跃表刷入
-        // 活跃表为空，直接返回
-
-        std::unique_lock<std::shared_mutex> lock2(cur_mtx);
-        if (current_table->get_size() == 0)
+        std::unique_lock<std::shared_mutex> lock1(frozen_mtx);
+        if (frozen_tables.empty())
         {
-            return nullptr;
+            // 如果为空，将活跃表刷入
+            // 活跃表为空，直接返回
+
+            std::unique_lock<std::shared_mutex> lock2(cur_mtx);
+            if (current_table->get_size() == 0)
+            {
+                flushed_count = 0;
+                return nullptr;
+            }
+
+            frozen_cur_table_();
         }
 
-        frozen_tables.push_front(current_table); // 最近插入的表插入队头
-        frozen_bytes += current_table->get_size();
-        current_table = std::make_shared<SkipList>();
+        tables.assign(frozen_tables.begin(), frozen_tables.end());
     }
+    flushed_count = tables.size();
 
-    std::shared_ptr<SkipList> table = frozen_tables.back(); // 取出插入时间最长的表
-    frozen_tables.pop_back();
-    frozen_bytes -= table->get_size();
+    // 冻结表不会再被修改，构建 SST 时不需要持有锁，读操作可以继续访问这些表
+    // 多路归并所有冻结表，key 和 value 直接从 arena 写入 builder，不产生中间拷贝
+    struct Cursor
+    {
+        SkipListIterator iter;
+        size_t idx; // 表的下标，越小越新
+    };
+    // 堆比较函数：key 升序，key 相同时事务 id 大的优先，再相同时较新的表优先
+    auto cursor_greater = [](const Cursor &a, const Cursor &b)
+    {
+        int cmp = a.iter.get_key_view().compare(b.iter.get_key_view());
+        if (cmp != 0)
+        {
+            return cmp > 0;
+        }
+        if (a.iter.get_tranc_id() != b.iter.get_tranc_id())
+        {
+            return a.iter.get_tranc_id() < b.iter.get_tranc_id();
+        }
+        return a.idx > b.idx;
+    };
 
-    auto flush_data = table->flush(); // 获取所有键值对
-    for (auto &[k, v, t] : flush_data)
+    std::vector<Cursor> heap;
+    for (size_t i = 0; i < tables.size(); i++)
     {
-        builder.add(k, v, t);
+        auto iter = tables[i]->begin();
+        if (iter.is_valid())
+        {
+            heap.push_back(Cursor{std::move(iter), i});
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), cursor_greater);
+
+    // 同一个 key 的版本按事务 id 从大到小出现，遇到第一个不大于 gc_tranc_id 的版本后，
+    // 之后的版本都被它遮蔽，直接跳过
+    std::optional<std::string_view> last_key;
+    uint64_t last_tranc_id = 0;
+    bool shadowed = false;
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), cursor_greater);
+        Cursor &cursor = heap.back();
+        std::string_view key = cursor.iter.get_key_view();
+        uint64_t tranc_id = cursor.iter.get_tranc_id();
+
+        bool skip = false;
+        if (key != last_key)
+        {
+            last_key = key;
+            shadowed = false;
+        }
+        else if (shadowed || tranc_id == last_tranc_id)
+        {
+            // 被遮蔽的旧版本，或者较旧的表中重复的 (key, 事务 id)
+            skip = true;
+        }
+
+        if (!skip)
+        {
+            if (tranc_id <= gc_tranc_id)
+            {
+                shadowed = true;
+            }
+            last_tranc_id = tranc_id;
+            builder.add(key, cursor.iter.get_value_view(), tranc_id);
+        }
+
+        ++cursor.iter;
+        if (cursor.iter.is_valid())
+        {
+            std::push_heap(heap.begin(), heap.end(), cursor_greater);
+        }
+        else
+        {
+            heap.pop_back();
+        }
     }
 
     auto sst = builder.build(sst_id, sst_path, block_cache);
     return sst;
 }
 
-HeapIterator Memtable::begin(uint64_t tranc_id)
+void Memtable::pop_last(size_t count)
+{
+    std::unique_lock<std::shared_mutex> lock(frozen_mtx);
+    while (count > 0 && !frozen_tables.empty())
+    {
+        frozen_bytes -= frozen_tables.back()->get_size();
+        frozen_tables.pop_back();
+        count--;
+    }
+}
+
+size_t Memtable::get_frozen_count()
+{
+    std::shared_lock<std::shared_mutex> lock(frozen_mtx);
+    return frozen_tables.size();
+}
+
+MemMergeIterator Memtable::begin(uint64_t tranc_id)
 {
     std::shared_lock<std::shared_mutex> lock1(frozen_mtx);
     std::shared_lock<std::shared_mutex> lock2(cur_mtx);
 
-    std::vector<SearchItem> item_vec;
-    for (auto iter = current_table->begin(); iter != current_table->end(); ++iter)
+    std::vector<std::pair<SkipListIterator, SkipListIterator>> ranges;
+    ranges.emplace_back(current_table->begin(), current_table->end());
+    for (auto &table : frozen_tables)
     {
-        if (tranc_id != 0 && iter.get_tranc_id() != tranc_id)
-        {
-            continue;
-        }
-        item_vec.emplace_back(iter.get_key(), iter.get_value(), 0, 0, iter.get_tranc_id());
+        ranges.emplace_back(table->begin(), table->end());
     }
 
-    int table_idx = 1;
-    for (auto ft = frozen_tables.begin(); ft != frozen_tables.end(); ft++)
-    {
-        auto table = *ft;
-        for (auto iter = table->begin(); iter != table->end(); ++iter)
-        {
-            if (tranc_id != 0 && iter.get_tranc_id() != tranc_id)
-            {
-                continue;
-            }
-            item_vec.emplace_back(iter.get_key(), iter.get_value(), table_idx, 0, iter.get_tranc_id());
-        }
-        table_idx++;
-    }
-    return HeapIterator(item_vec, tranc_id);
+    return MemMergeIterator(std::move(ranges), tranc_id);
 }
 
-HeapIterator Memtable::end(uint64_t tranc_id)
+MemMergeIterator Memtable::end(uint64_t tranc_id)
 {
-    return HeapIterator();
+    return MemMergeIterator();
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "../../include/memtable/memtable_iterator.h"
+#include <algorithm>
+
+MemMergeIterator::MemMergeIterator(std::vector<std::pair<SkipListIterator, SkipListIterator>> ranges, uint64_t max_tranc_id,
+                                   bool skip_delete)
+    : max_tranc_id_(max_tranc_id), skip_delete_(skip_delete)
+{
+    cursors.reserve(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        auto &[begin, end] = ranges[i];
+        if (begin.is_valid() && begin != end)
+        {
+            cursors.push_back(Cursor{std::move(begin), std::move(end), i});
+        }
+    }
+
+    heap.reserve(cursors.size());
+    for (size_t i = 0; i < cursors.size(); i++)
+    {
+        heap.push_back(i);
+    }
+    auto cmp = [this](size_t a, size_t b)
+    {
+        return cursor_greater(cursors[a], cursors[b]);
+    };
+    std::make_heap(heap.begin(), heap.end(), cmp);
+
+    seek_visible();
+}
+
+// 堆比较函数：key 升序，key 相同时事务 id 大的优先，再相同时较新的跳表优先
+bool MemMergeIterator::cursor_greater(const Cursor &a, const Cursor &b)
+{
+    int cmp = a.iter.get_key_view().compare(b.iter.get_key_view());
+    if (cmp != 0)
+    {
+        return cmp > 0;
+    }
+    if (a.iter.get_tranc_id() != b.iter.get_tranc_id())
+    {
+        return a.iter.get_tranc_id() < b.iter.get_tranc_id();
+    }
+    return a.idx > b.idx;
+}
+
+void MemMergeIterator::advance_top()
+{
+    auto cmp = [this](size_t a, size_t b)
+    {
+        return cursor_greater(cursors[a], cursors[b]);
+    };
+
+    std::pop_heap(heap.begin(), heap.end(), cmp);
+    Cursor &cursor = cursors[heap.back()];
+    ++cursor.iter;
+    if (cursor.iter.is_valid() && cursor.iter != cursor.end)
+    {
+        std::push_heap(heap.begin(), heap.end(), cmp);
+    }
+    else
+    {
+        heap.pop_back();
+    }
+}
+
+void MemMergeIterator::seek_visible()
+{
+    valid = false;
+    while (!heap.empty())
+    {
+        // key 指向 arena 中的数据，游标移动后仍然有效
+        std::string_view key = cursors[heap.front()].iter.get_key_view();
+        bool found = false;
+
+        // 同一个 key 的所有版本依次出现在堆顶，取第一个可见的版本，其余的跳过
+        while (!heap.empty() && cursors[heap.front()].iter.get_key_view() == key)
+        {
+            const SkipListIterator &top = cursors[heap.front()].iter;
+            if (!found && (max_tranc_id_ == 0 || top.get_tranc_id() <= max_tranc_id_))
+            {
+                found = true;
+                cur_key = key;
+                cur_value = top.get_value_view();
+                cur_tranc_id = top.get_tranc_id();
+            }
+            advance_top();
+        }
+
+        // value 为空表示该 key 已经被删除
+        if (found && (!skip_delete_ || !cur_value.empty()))
+        {
+            valid = true;
+            return;
+        }
+    }
+}
+
+MemMergeIterator::pointer MemMergeIterator::operator->() const
+{
+    update_current();
+    return current.get();
+}
+
+BaseIterator::value_type MemMergeIterator::operator*() const
+{
+    return std::make_pair(std::string(cur_key), std::string(cur_value));
+}
+
+BaseIterator &MemMergeIterator::operator++()
+{
+    if (valid)
+    {
+        seek_visible();
+    }
+    return *this;
+}
+
+bool MemMergeIterator::operator==(const BaseIterator &other) const
+{
+    if (other.get_type() != IteratorType::MemMergeIterator)
+    {
+        return false;
+    }
+    auto &other2 = dynamic_cast<const MemMergeIterator &>(other);
+    if (!valid || !other2.valid)
+    {
+        return valid == other2.valid;
+    }
+    return cur_key == other2.cur_key && cur_tranc_id == other2.cur_tranc_id;
+}
+
+bool MemMergeIterator::operator!=(const BaseIterator &other) const
+{
+    return !(*this == other);
+}
+
+IteratorType MemMergeIterator::get_type() const
+{
+    return IteratorType::MemMergeIterator;
+}
+
+uint64_t MemMergeIterator::get_tranc_id() const
+{
+    return cur_tranc_id;
+}
+
+bool MemMergeIterator::is_end() const { return !valid; }
+bool MemMergeIterator::is_valid() const { return valid; }
+
+void MemMergeIterator::update_current() const
+{
+    if (valid)
+    {
+        current = std::make_shared<value_type>(cur_key, cur_value);
+    }
+    else
+    {
+        current.reset();
+    }
+}
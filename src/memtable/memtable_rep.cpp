@@ -0,0 +1,18 @@
+#include "../../include/memtable/memtable_rep.h"
+#include "../../include/memtable/art_rep.h"
+#include "../../include/memtable/hash_table_rep.h"
+#include "../../include/skiplist/skiplist.h"
+
+std::shared_ptr<MemTableRep> new_memtable_rep(MemTableRepType type, size_t size_limit)
+{
+    switch (type)
+    {
+    case MemTableRepType::HashTable:
+        return std::make_shared<HashTableRep>();
+    case MemTableRepType::Art:
+        return std::make_shared<ArtRep>();
+    case MemTableRepType::SkipList:
+    default:
+        return std::make_shared<SkipList>(16, size_limit);
+    }
+}
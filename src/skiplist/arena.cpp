@@ -0,0 +1,50 @@
+#include "../../include/skiplist/arena.h"
+#include "../../include/const.h"
+#include <cstdint>
+
+Arena::Arena() : current(nullptr), memory_usage(0) {}
+
+char *Arena::allocate(size_t bytes)
+{
+  // 统一按 8 字节对齐，节点中的指针和事务 id 都可以直接访问
+  bytes = (bytes + 7) & ~static_cast<size_t>(7);
+
+  if (bytes > LSM_ARENA_CHUNK_SIZE / 4)
+  {
+    // 大对象单独申请一个 chunk，避免浪费当前 chunk 的剩余空间
+    std::lock_guard<std::mutex> lock(mtx);
+    return new_chunk(bytes, bytes)->data.get();
+  }
+
+  while (true)
+  {
+    Chunk *chunk = current.load(std::memory_order_acquire);
+    if (chunk != nullptr)
+    {
+      size_t offset = chunk->used.fetch_add(bytes, std::memory_order_relaxed);
+      if (offset + bytes <= chunk->capacity)
+      {
+        return chunk->data.get() + offset;
+      }
+    }
+
+    // 当前 chunk 已经用完，剩余空间直接丢弃，由一个线程负责换上新的 chunk
+    std::lock_guard<std::mutex> lock(mtx);
+    if (current.load(std::memory_order_acquire) == chunk)
+    {
+      current.store(new_chunk(LSM_ARENA_CHUNK_SIZE, 0), std::memory_order_release);
+    }
+  }
+}
+
+Arena::Chunk *Arena::new_chunk(size_t capacity, size_t used)
+{
+  chunks.push_back(std::make_unique<Chunk>(capacity, used));
+  memory_usage.fetch_add(capacity, std::memory_order_relaxed);
+  return chunks.back().get();
+}
+
+size_t Arena::get_memory_usage() const
+{
+  return memory_usage.load(std::memory_order_relaxed);
+}
@@ -1,25 +1,136 @@
 #include "../../include/skiplist/skiplist.h"
+#include "../../include/const.h"
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
-#include <tuple>
 
 /*********************** SkipList *******************/
 
+// 取 key 的前 8 个字节按大端序组成整数，不足 8 字节的部分补 0
+// 两个整数的大小关系与前 8 个字节的字典序一致
+static inline uint64_t load_prefix(std::string_view key)
+{
+  uint64_t prefix = 0;
+  memcpy(&prefix, key.data(), std::min<size_t>(key.size(), sizeof(uint64_t)));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  prefix = __builtin_bswap64(prefix);
+#endif
+  return prefix;
+}
+
+// 比较节点的 key 与 key，key_prefix 是 key 的前缀(load_prefix)
+static int compare_key(const SkipListNode *node, std::string_view key, uint64_t key_prefix)
+{
+  // 前 8 个字节不同时只需要比较内联的前缀，不用访问 key 本身
+  if (node->key_prefix != key_prefix)
+  {
+    return node->key_prefix < key_prefix ? -1 : 1;
+  }
+
+  // 前缀相同：前 min(8, 较短的长度) 个字节相同，较短的 key 不足 8 字节时它一定是较长 key 的前缀
+  size_t min_len = std::min<size_t>(node->key_len, key.size());
+  size_t start = std::min(sizeof(uint64_t), min_len);
+  int cmp = memcmp(node->key_data + start, key.data() + start, min_len - start);
+  if (cmp != 0)
+  {
+    return cmp;
+  }
+  if (node->key_len == key.size())
+  {
+    return 0;
+  }
+  return node->key_len < key.size() ? -1 : 1;
+}
+
+// 比较节点与 (key, tranc_id) 的先后顺序
+// key 升序，key 相同时事务 id 更大的排在前面
+// 返回值 <0 表示节点排在前面，0 表示相等，>0 表示节点排在后面
+static int compare_node(const SkipListNode *node, std::string_view key, uint64_t key_prefix, uint64_t tranc_id)
+{
+  int cmp = compare_key(node, key, key_prefix);
+  if (cmp != 0)
+  {
+    return cmp;
+  }
+  if (node->tranc_id == tranc_id)
+  {
+    return 0;
+  }
+  return node->tranc_id > tranc_id ? -1 : 1;
+}
+
+static int compare_node(const SkipListNode *node, std::string_view key, uint64_t tranc_id)
+{
+  return compare_node(node, key, load_prefix(key), tranc_id);
+}
+
+// 跳过被逻辑删除的节点
+static const SkipListNode *skip_deleted(const SkipListNode *node)
+{
+  while (node && node->is_deleted())
+  {
+    node = node->next(0);
+  }
+  return node;
+}
+
 // 构造函数
-SkipList::SkipList(int max_level)
+SkipList::SkipList(int max_level, size_t size_limit)
 {
-  this->max_level = max_level;
-  this->head = std::make_shared<SkipListNode>("", "", max_level, 0); // 创建头节点
+  this->max_level = std::min(max_level, MAX_LEVEL_LIMIT);
+  this->arena = std::make_shared<Arena>();
+  this->head = new_node("", "", this->max_level, 0); // 创建头节点
   this->current_level = 1;
 
-  // 随机数
-  this->dis_01 = std::uniform_int_distribution<>(0, 1);
-  this->dis_level = std::uniform_int_distribution<>(0, (1 << max_level) - 1);
-  this->gen = std::mt19937(this->rd());
+  // 位数取 2 的幂，字的下标可以直接用掩码得到
+  size_t bloom_bits = LSM_SKIPLIST_BLOOM_MIN_BITS;
+  while (bloom_bits < size_limit / LSM_SKIPLIST_BLOOM_BYTES_PER_BIT)
+  {
+    bloom_bits <<= 1;
+  }
+  size_t bloom_word_count = bloom_bits / 64;
+  this->bloom_words = std::make_unique<std::atomic<uint64_t>[]>(bloom_word_count);
+  this->bloom_mask = bloom_word_count - 1;
+}
+
+// 由 key 的哈希值得到所在的字和字内需要置位的掩码
+// 字的下标取哈希的低位，字内的 4 个位置由哈希的高位依次决定
+static inline std::pair<size_t, uint64_t> bloom_probe(std::string_view key, size_t mask)
+{
+  uint64_t h = std::hash<std::string_view>{}(key);
+  size_t word = h & mask;
+  uint64_t bits = 0;
+  uint64_t g = h * 0x9E3779B97F4A7C15ULL; // 重新打散，避免与字下标使用相同的位
+  for (int i = 0; i < 4; i++)
+  {
+    bits |= 1ULL << ((g >> (58 - i * 6)) & 63);
+  }
+  return {word, bits};
+}
+
+void SkipList::bloom_add(std::string_view key)
+{
+  auto [word, bits] = bloom_probe(key, bloom_mask);
+  if ((bloom_words[word].load(std::memory_order_relaxed) & bits) != bits)
+  {
+    bloom_words[word].fetch_or(bits, std::memory_order_relaxed);
+  }
+}
+
+bool SkipList::may_contain(std::string_view key) const
+{
+  auto [word, bits] = bloom_probe(key, bloom_mask);
+  return (bloom_words[word].load(std::memory_order_relaxed) & bits) == bits;
 }
 
 int SkipList::random_level()
 {
+  // 每个线程使用独立的随机数生成器，并发插入时无需同步
+  thread_local std::mt19937 gen(std::random_device{}());
+  std::uniform_int_distribution<> dis_01(0, 1);
+
   int level = 1;
   // 通过抛硬币的方式生成随机层数
   // 每一次抛硬币都有50%的概率增加一层
@@ -30,197 +141,353 @@ int SkipList::random_level()
   return level; // [1, max_level]
 }
 
-void SkipList::put(const std::string &key, const std::string &value, uint64_t tranc_id)
+// 在 arena 中一次性分配节点、next 指针数组、key 和 value
+SkipListNode *SkipListNode::create(Arena &arena, std::string_view key, std::string_view value, int level, uint64_t tranc_id)
 {
-  //   if (value.empty()) {
-  //     throw std::runtime_error("value cannot be empty"); // 值为空，抛出异常
-  //   }
-  int new_level = std::max(random_level(), current_level);
-  auto new_node = std::make_shared<SkipListNode>(key, value, new_level, tranc_id);
+  size_t node_bytes = sizeof(SkipListNode) + sizeof(std::atomic<SkipListNode *>) * (level - 1);
+  char *mem = arena.allocate(node_bytes + key.size() + sizeof(uint32_t) + value.size());
+
+  auto node = new (mem) SkipListNode;
+  char *key_mem = mem + node_bytes;
+  char *value_mem = key_mem + key.size();
+  memcpy(key_mem, key.data(), key.size());
+  uint32_t value_len = value.size();
+  memcpy(value_mem, &value_len, sizeof(uint32_t));
+  memcpy(value_mem + sizeof(uint32_t), value.data(), value.size());
+
+  node->key_prefix = load_prefix(key);
+  node->key_data = key_mem;
+  node->key_len = key.size();
+  node->tranc_id = tranc_id;
+  node->level = level;
+  node->value_slot.store(value_mem, std::memory_order_relaxed);
+  node->deleted.store(false, std::memory_order_relaxed);
+  for (int i = 0; i < level; i++)
+  {
+    new (&node->forward[i]) std::atomic<SkipListNode *>(nullptr);
+  }
+  return node;
+}
+
+const char *SkipListNode::new_value_slot(Arena &arena, std::string_view value)
+{
+  char *slot = arena.allocate(sizeof(uint32_t) + value.size());
+  uint32_t value_len = value.size();
+  memcpy(slot, &value_len, sizeof(uint32_t));
+  memcpy(slot + sizeof(uint32_t), value.data(), value.size());
+  return slot;
+}
 
-  //   标记当前的节点
-  //   初始化当前节点为头节点 head，用于遍历跳表
-  auto current = head;
+SkipListNode *SkipList::new_node(std::string_view key, std::string_view value, int level, uint64_t tranc_id)
+{
+  return SkipListNode::create(*arena, key, value, level, tranc_id);
+}
 
-  // 创建一个大小为 max_level 的向量 update，用于记录每一层的前驱节点。
-  std::vector<std::shared_ptr<SkipListNode>> update(max_level, nullptr);
+SkipListNode *SkipList::find_greater_or_equal(std::string_view key, uint64_t tranc_id, SkipListNode **prev) const
+{
+  SkipListNode *current = head;
+  uint64_t key_prefix = load_prefix(key);
+  SkipListNode *hi = nullptr; // 上一层停下时比较过的节点，已知不小于 key，下一层遇到它时不必再比较
 
-  // 从最高层开始向下遍历，找到每一层中小于给定 key 的最大节点，并将其记录到 update 中。
-  for (int i = current_level - 1; i >= 0; i--)
+  // 从最高层开始向下遍历，找到每一层中小于 (key, tranc_id) 的最大节点
+  for (int i = current_level.load(std::memory_order_relaxed) - 1; i >= 0; i--)
   {
-    while (current->forward[i] && *current->forward[i] < *new_node)
+    SkipListNode *next = current->next(i);
+    while (next && next != hi)
+    {
+      if (compare_node(next, key, key_prefix, tranc_id) >= 0)
+      {
+        hi = next;
+        break;
+      }
+      current = next;
+      next = current->next(i);
+    }
+    if (prev != nullptr)
     {
-      current = current->forward[i];
+      prev[i] = current;
     }
-    update[i] = current;
   }
+  return current->next(0);
+}
 
-  // 移动到最底层
-  current = current->forward[0];
-
-  // 判断 key 是否存在
-  if (current && current->key == key && current->tranc_id == tranc_id)
+void SkipList::find_splice_for_level(std::string_view key, uint64_t tranc_id, int level, SkipListNode **prev, SkipListNode **next) const
+{
+  // 节点不会被摘除，prev 一定仍然在目标位置之前，只需向后推进
+  SkipListNode *current = *prev;
+  SkipListNode *after = current->next(level);
+  uint64_t key_prefix = load_prefix(key);
+  while (after && compare_node(after, key, key_prefix, tranc_id) < 0)
   {
-    size_bytes += value.size() - current->value.size();
-    current->value = value;
-    current->tranc_id = tranc_id;
-    return;
+    current = after;
+    after = current->next(level);
   }
+  *prev = current;
+  *next = after;
+}
+
+void SkipList::put(std::string_view key, std::string_view value, uint64_t tranc_id)
+{
+  //   if (value.empty()) {
+  //     throw std::runtime_error("value cannot be empty"); // 值为空，抛出异常
+  //   }
+
+  // prev 记录每一层插入位置的前驱
+  SkipListNode *prev[MAX_LEVEL_LIMIT];
 
-  //   value不存在则需要创建
-  // int new_level = std::max(random_level(), current_level);
-  for (int i = current_level; i < new_level; ++i)
+  int old_level = current_level.load(std::memory_order_relaxed);
+  find_greater_or_equal(key, tranc_id, prev);
+  for (int i = old_level; i < max_level; i++)
   {
-    update[i] = head;
+    prev[i] = head;
   }
 
-  size_bytes += new_node->key.size() + new_node->value.size() + sizeof(uint64_t);
+  insert_with_splice(key, value, tranc_id, prev);
+}
+
+void SkipList::put_batch(std::vector<std::pair<std::string_view, std::string_view>> kvs, uint64_t tranc_id)
+{
+  // 按 key 排序，相同的 key 保持原来的顺序，后写入的覆盖先写入的
+  std::stable_sort(kvs.begin(), kvs.end(), [](const auto &a, const auto &b)
+                   { return a.first < b.first; });
+
+  // 上一次插入时每一层的前驱(finger)
+  // key 递增，前驱一定仍然位于下一个 key 之前，只需要从前驱向后查找
+  SkipListNode *prev[MAX_LEVEL_LIMIT];
+  for (int i = 0; i < max_level; i++)
+  {
+    prev[i] = head;
+  }
 
-  // 三种状态的update
-  // 第0层一定更新
-  // 如果创建了新的层级，所有层级都更新
-  // 每次50%的概率更新，某层不更新则中断更新
-  int radn_bits = dis_level(gen);
-  for (int i = 0; i < new_level; ++i)
+  for (auto &[key, value] : kvs)
   {
-    bool is_update = false;
-    if (i == 0 || (new_level > current_level) || (radn_bits & (1 << i)))
+    // 从第0层向上找到第一个仍然包住 key 的层：前驱的后继不小于 key
+    // 更高的层跨度更大，同样包住 key，只需要从这一层开始向下查找
+    int top_level = current_level.load(std::memory_order_relaxed);
+    int level = 0;
+    while (level < top_level - 1)
     {
-      is_update = true; // 需要更新
+      SkipListNode *next = prev[level]->next(level);
+      if (next == nullptr || compare_node(next, key, tranc_id) >= 0)
+      {
+        break;
+      }
+      level++;
     }
-    if (is_update)
+
+    for (int i = level; i >= 0; i--)
     {
-      // 更新forward与backward
-      new_node->forward[i] = update[i]->forward[i];
-      if (new_node->forward[i])
+      if (i < level)
       {
-        new_node->forward[i]->set_backward(i, new_node);
+        prev[i] = prev[i + 1];
       }
-
-      update[i]->forward[i] = new_node;
-      new_node->set_backward(i, update[i]);
+      SkipListNode *next;
+      find_splice_for_level(key, tranc_id, i, &prev[i], &next);
     }
-    else
-      break; // 某一层不需要更新，则停止更新更高层
-  }
 
-  current_level = new_level; // 更新当前的层数
+    insert_with_splice(key, value, tranc_id, prev);
+  }
 }
 
-void SkipList::remove(const std::string &key)
+void SkipList::insert_with_splice(std::string_view key, std::string_view value, uint64_t tranc_id, SkipListNode **prev)
 {
-  std::vector<std::shared_ptr<SkipListNode>> update(max_level, nullptr);
+  SkipListNode *next[MAX_LEVEL_LIMIT];
 
-  //   标记当前的节点
-  auto current = head;
+  int new_level = random_level();
+  SkipListNode *node = nullptr;
 
-  for (int i = current->forward.size() - 1; i >= 0; i--)
+  // 在节点可见之前记录到布隆过滤器中，读线程看到节点时一定也能通过过滤器
+  bloom_add(key);
+
+  for (int i = 0; i < new_level; i++)
   {
-    while (current->forward[i] && current->forward[i]->key < key)
+    while (true)
     {
-      current = current->forward[i];
-    }
-    update[i] = current;
-  }
+      find_splice_for_level(key, tranc_id, i, &prev[i], &next[i]);
 
-  // 移动到最底层
-  current = current->forward[0];
+      // 判断 key 是否存在，可能是其他线程刚刚插入的
+      if (i == 0 && next[0] && compare_node(next[0], key, tranc_id) == 0)
+      {
+        // 旧的 value 留在 arena 中，随 arena 一起释放
+        const char *old_slot = next[0]->value_slot.exchange(SkipListNode::new_value_slot(*arena, value), std::memory_order_acq_rel);
+        if (next[0]->deleted.exchange(false, std::memory_order_acq_rel))
+        {
+          // 节点之前被逻辑删除，重新写入后恢复可见
+          size_bytes.fetch_add(key.size() + value.size() + sizeof(uint64_t), std::memory_order_relaxed);
+          return;
+        }
+        uint32_t old_len;
+        memcpy(&old_len, old_slot, sizeof(uint32_t));
+        size_bytes.fetch_add(value.size() - old_len, std::memory_order_relaxed);
+        return;
+      }
 
-  //   如果找到目标节点, 执行删除操作
-  if (current && current->key == key)
-  {
-    // 记录要更新的节点
-    for (int i = 0; i < current_level; i++)
-    {
-      if (update[i]->forward[i] != current)
+      if (node == nullptr)
+      {
+        //   value不存在则需要创建
+        node = new_node(key, value, new_level, tranc_id);
+      }
+
+      // 先设置新节点的后继，再通过 CAS 发布到前驱上
+      // 失败说明有其他线程在同一位置插入了节点，重新定位后重试
+      node->forward[i].store(next[i], std::memory_order_relaxed);
+      if (prev[i]->cas_next(i, next[i], node))
       {
         break;
       }
-      update[i]->forward[i] = current->forward[i];
     }
   }
 
-  // 更新 backward 指针
-  for (int i = 0; i < current->backward.size() && i < current_level; ++i)
+  // 更新当前的层数，只会增加
+  int level = current_level.load(std::memory_order_relaxed);
+  while (new_level > level && !current_level.compare_exchange_weak(level, new_level, std::memory_order_relaxed))
   {
-    if (current->forward[i])
-    {
-      current->forward[i]->set_backward(i, update[i]);
-    }
   }
 
-  //   更新内存大小
-  size_bytes -= key.size() + current->value.size();
+  size_bytes.fetch_add(key.size() + value.size() + sizeof(uint64_t), std::memory_order_relaxed);
+}
+
+void SkipList::remove(std::string_view key)
+{
+  // 找到 key 最新的未删除版本(事务 id 最大)
+  SkipListNode *current = find_greater_or_equal(key, UINT64_MAX, nullptr);
+  while (current && current->key() == key && current->is_deleted())
+  {
+    current = current->next(0);
+  }
+
+  //   没有找到目标节点
+  if (!current || current->key() != key)
+  {
+    return;
+  }
 
-  // 如果我们的删除节点是最高层的节点, 需要更新跳表的当前层级
-  while (current_level > 1 && head->forward[current_level - 1] == nullptr)
+  // 节点仍留在跳表中，只打上删除标记，读线程遍历时会跳过它
+  if (!current->deleted.exchange(true, std::memory_order_acq_rel))
   {
-    current_level--;
+    //   更新内存大小
+    size_bytes.fetch_sub(current->key_len + current->value().size() + sizeof(uint64_t), std::memory_order_relaxed);
   }
 }
 
-SkipListIterator SkipList::get(const std::string &key, uint64_t tranc_id)
+SkipListIterator SkipList::get(std::string_view key, uint64_t tranc_id)
 {
-  auto current = head;
+  // 相同 key 的记录按事务 id 从大到小排列
+  // 查找第一个不小于 (key, tranc_id) 的节点，即事务 id 小于等于 tranc_id 的最新记录
+  // trancId == 0 表示没有开启事务，直接返回最新的记录
+  uint64_t search_id = tranc_id == 0 ? UINT64_MAX : tranc_id;
+  return resolve_get(find_greater_or_equal(key, search_id, nullptr), key);
+}
 
-  // 从高层进行查找
-  for (int i = current->forward.size() - 1; i >= 0; i--)
+SkipListIterator SkipList::resolve_get(const SkipListNode *node, std::string_view key) const
+{
+  while (node && node->key() == key && node->is_deleted())
   {
-    while (current->forward[i] && current->forward[i]->key < key)
-    {
-      current = current->forward[i];
-    }
+    node = node->next(0);
   }
 
-  // 移动到最底层
-  current = current->forward[0];
-  if (tranc_id == 0)
+  if (node && node->key() == key)
   {
-    // trancId == 0 表示没有开启事务，直接返回最新的记录
-    if (current && current->key == key)
-    {
-      return SkipListIterator(current);
-    }
+    // 满足事务的可见性
+    return SkipListIterator(node, arena);
   }
-  else
+  return SkipListIterator(nullptr);
+}
+
+std::vector<SkipListIterator> SkipList::get_batch(const std::vector<std::string_view> &keys, uint64_t tranc_id)
+{
+  // 单个 key 的查找每一步都依赖上一步读到的指针，缓存未命中时只能等待
+  // 这里把一组查找交替推进：每个查找前进一步后预取它下一步要比较的节点，
+  // 轮到它时节点大概率已经在缓存中
+  struct Search
   {
-    while (current && current->key == key)
+    SkipListNode *node;
+    int level;
+    bool done;
+    uint64_t key_prefix;
+    SkipListNode *hi; // 与 find_greater_or_equal 相同，已知不小于 key 的节点
+  };
+
+  uint64_t search_id = tranc_id == 0 ? UINT64_MAX : tranc_id;
+  int top_level = current_level.load(std::memory_order_relaxed);
+  std::vector<SkipListIterator> results;
+  results.reserve(keys.size());
+
+  Search searches[LSM_SKIPLIST_LOOKUP_GROUP];
+  for (size_t group_begin = 0; group_begin < keys.size(); group_begin += LSM_SKIPLIST_LOOKUP_GROUP)
+  {
+    size_t group_size = std::min<size_t>(LSM_SKIPLIST_LOOKUP_GROUP, keys.size() - group_begin);
+    for (size_t j = 0; j < group_size; j++)
+    {
+      searches[j] = Search{head, top_level - 1, false, load_prefix(keys[group_begin + j]), nullptr};
+      __builtin_prefetch(head->next(top_level - 1));
+    }
+
+    size_t remaining = group_size;
+    while (remaining > 0)
     {
-      // 只返回小于等于事务id的记录
-      // 且最接近事务id
-      if (tranc_id != 0)
+      for (size_t j = 0; j < group_size; j++)
       {
-        if (current->tranc_id <= tranc_id)
+        Search &search = searches[j];
+        if (search.done)
+        {
+          continue;
+        }
+
+        SkipListNode *next = search.node->next(search.level);
+        if (next && next != search.hi && compare_node(next, keys[group_begin + j], search.key_prefix, search_id) < 0)
+        {
+          // 同一层向右移动
+          search.node = next;
+        }
+        else if (search.level == 0)
         {
-          // 满足事务的可见性
-          return SkipListIterator(current);
+          // next 就是第一个不小于 (key, tranc_id) 的节点，先记在 node 中
+          search.node = next;
+          search.done = true;
+          remaining--;
+          continue;
         }
         else
         {
-          // 跳过一次
-          // 出现的连续key的事务是从大到小的
-          current = current->forward[0];
+          // 向下一层
+          search.hi = next;
+          search.level--;
+        }
+        // 预取下一步要比较的节点(key 在 arena 中紧跟在节点之后，通常位于相邻的缓存行)
+        SkipListNode *prefetch = search.node->next(search.level);
+        if (prefetch)
+        {
+          __builtin_prefetch(prefetch);
+          __builtin_prefetch(reinterpret_cast<const char *>(prefetch) + 64);
         }
       }
-      else
-      {
-        // 满足事务的可见性
-        return SkipListIterator(current);
-      }
+    }
+
+    for (size_t j = 0; j < group_size; j++)
+    {
+      results.push_back(resolve_get(searches[j].node, keys[group_begin + j]));
     }
   }
-  return SkipListIterator(nullptr);
+  return results;
 }
 
 void SkipList::clear()
 {
-  head = std::make_shared<SkipListNode>("", "", max_level, 0);
+  // 旧的 arena 会在没有迭代器引用后整体释放
+  arena = std::make_shared<Arena>();
+  head = new_node("", "", max_level, 0);
+  current_level = 1;
   size_bytes = 0;
+  for (size_t i = 0; i <= bloom_mask; i++)
+  {
+    bloom_words[i].store(0, std::memory_order_relaxed);
+  }
 }
 
 SkipListIterator SkipList::begin()
 {
-  return SkipListIterator(head->forward[0]);
+  return SkipListIterator(skip_deleted(head->next(0)), arena);
 }
 
 SkipListIterator SkipList::end()
@@ -230,28 +497,43 @@ SkipListIterator SkipList::end()
 
 size_t SkipList::get_size() const
 {
-  return size_bytes;
+  return size_bytes.load(std::memory_order_relaxed);
 }
 
-std::vector<std::tuple<std::string, std::string, uint64_t>> SkipList::flush()
+size_t SkipList::get_memory_usage() const
 {
-  std::vector<std::tuple<std::string, std::string, uint64_t>> res;
-  auto node = head->forward[0];
+  return arena->get_memory_usage();
+}
 
-  while (node)
+/*********************** SkipListIterator *******************/
+SkipListIterator::SkipListIterator(std::shared_ptr<const Snapshot> snapshot, size_t pos, std::shared_ptr<Arena> arena)
+    : current(nullptr), arena(std::move(arena)), snapshot(std::move(snapshot)), pos(pos)
+{
+  // 快照中的节点之后可能被逻辑删除，与跳表一样跳过
+  while (this->pos < this->snapshot->size() && (*this->snapshot)[this->pos]->is_deleted())
   {
-    res.emplace_back(node->key, node->value, node->tranc_id);
-    node = node->forward[0];
+    this->pos++;
   }
-  return res;
+  current = this->pos < this->snapshot->size() ? (*this->snapshot)[this->pos] : nullptr;
 }
 
-/*********************** SkipListIterator *******************/
 BaseIterator &SkipListIterator::operator++()
 {
-  if (current)
+  if (current == nullptr)
   {
-    current = current->forward[0];
+    return *this;
+  }
+  if (snapshot)
+  {
+    do
+    {
+      pos++;
+    } while (pos < snapshot->size() && (*snapshot)[pos]->is_deleted());
+    current = pos < snapshot->size() ? (*snapshot)[pos] : nullptr;
+  }
+  else
+  {
+    current = skip_deleted(current->next(0));
   }
   return *this;
 }
@@ -276,7 +558,7 @@ bool SkipListIterator::operator==(const BaseIterator &other) const
   {
     return false;
   }
-  auto other_iter = dynamic_cast<const SkipListIterator &>(other);
+  auto &other_iter = dynamic_cast<const SkipListIterator &>(other);
   return current == other_iter.current;
 }
 bool SkipListIterator::operator!=(const BaseIterator &other) const
@@ -290,7 +572,7 @@ BaseIterator::value_type SkipListIterator::operator*() const
   {
     throw std::runtime_error("SkipIterator: deference null pointer");
   }
-  return std::make_pair(current->key, current->value);
+  return std::make_pair(std::string(current->key()), std::string(current->value()));
 }
 
 uint64_t SkipListIterator::get_tranc_id() const
@@ -300,11 +582,11 @@ uint64_t SkipListIterator::get_tranc_id() const
 
 std::string SkipListIterator::get_key() const
 {
-  return current->key;
+  return std::string(current->key());
 }
 std::string SkipListIterator::get_value() const
 {
-  return current->value;
+  return std::string(current->value());
 }
 
 bool SkipListIterator::is_valid() const
@@ -336,115 +618,42 @@ bool SkipListIterator::is_end() const
 // }
 std::optional<std::pair<SkipListIterator, SkipListIterator>> SkipList::iters_monotony_predicate(std::function<int(const std::string &)> predicate)
 {
-  auto current = head; // 从头节点开始遍历
+  // 谓词是单调的：区间左侧的 key 返回 >0，区间内返回 0，区间右侧返回 <0
+  // 因此可以像普通查找一样从高层向下逐层逼近区间的两个端点，不需要反向指针
 
-  // 分别用于存储区间的起始和结束迭代器，初始值为空
-  SkipListIterator begin_iter(nullptr);
-  SkipListIterator end_iter(nullptr);
-
-  // 从最高层开始查找，根据谓词函数 predicate 查找第一个满足条件的节点。
-  bool find1 = false;
-  for (int i = current_level - 1; i >= 0; i--)
+  // 找左端点：最后一个 predicate > 0 的节点，其后继就是第一个满足条件的节点
+  SkipListNode *current = head;
+  int top_level = current_level.load(std::memory_order_relaxed);
+  for (int i = top_level - 1; i >= 0; i--)
   {
-    while (!find1)
+    SkipListNode *next = current->next(i);
+    while (next && predicate(std::string(next->key())) > 0)
     {
-      auto forward_i = current->forward[i]; // 获取当前层节点的 forward 指针
-      if (forward_i == nullptr)             // 如果前向指针为空，说明已经达到了该层的末尾
-      {
-        break;
-      }
-      auto direction = predicate(forward_i->key); // 调用谓词函数判断当前节点是否满足条件。
-      if (direction == 0)                         // 如果返回值为0，表示找到满足条件的节点。
-      {
-        find1 = true;        // 标记已找到
-        current = forward_i; // 更新当前节点为找到的节点。
-        break;               // 跳出循环
-      }
-      else if (direction < 0) // 表示需要向右移动
-      {
-        break; // 停止当前层的查找
-      }
-      else // 返回值大于0，表示需要继续向右移动。
-      {
-        current = forward_i; // 更新当前节点为前向节点
-      }
+      current = next;
+      next = current->next(i);
     }
   }
-  if (!find1) // 没找到满足条件的节点，返回空结果
+
+  const SkipListNode *first = skip_deleted(current->next(0));
+  if (first == nullptr || predicate(std::string(first->key())) != 0) // 没找到满足条件的节点，返回空结果
   {
     return std::nullopt;
   }
 
-  // 此时找到的节点是第一个满足要求的节点，
-  // 最左侧满足条件的节点（即区间的起始节点）
-
-  // 记录当前位置，用于后续查找区间
-  auto current_2 = current;
-
-  // 向右查找区间的结束节点。
-  for (int i = current->backward.size() - 1; i >= 0; i--) // 从高到低遍历 forward 指针。
+  // 找右端点：最后一个 predicate >= 0 的节点，其后继就是区间的结束位置
+  current = head;
+  for (int i = top_level - 1; i >= 0; i--)
   {
-    while (true)
+    SkipListNode *next = current->next(i);
+    while (next && predicate(std::string(next->key())) >= 0)
     {
-      // td::weak_ptr::lock()
-      // 作用：lock() 方法尝试将一个 std::weak_ptr 转换为 std::shared_ptr。如果 std::weak_ptr 指向的对象仍然存在，
-      // 则返回一个指向该对象的 std::shared_ptr；否则返回一个空的 std::shared_ptr。
-      // current->backward[i].lock() 尝试将 std::weak_ptr 转换为 std::shared_ptr<SkipListNode>。
-      // 如果转换后的 std::shared_ptr 为空（即 nullptr），说明该 std::weak_ptr 指向的对象已经被销毁。
-      // 如果转换后的 std::shared_ptr 等于头节点 head，说明已经到达跳跃表的起始位置。
-      if (current->backward[i].lock() == nullptr || current->backward[i].lock() == head)
-      {
-        // 没有实际存储键值对的前向节点了
-        break;
-      }
-      auto direction = predicate(current->backward[i].lock()->key);
-      if (direction == 0) // 找到满足条件的节点
-      {
-        current = current->backward[i].lock();
-        continue;
-      }
-      else if (direction > 0)
-      {
-        // 需要更小的步长
-        break;
-      }
-      else
-      {
-        throw std::runtime_error("iters_monotony_predicate error: invalid direction");
-      }
+      current = next;
+      next = current->next(i);
     }
   }
 
-  begin_iter = SkipListIterator(current); // 找左端点
-
-  // 找右端点
-  for (int i = current_2->forward.size() - 1; i >= 0; i--)
-  {
-    while (true)
-    {
-      if (current_2->forward[i] == nullptr)
-      {
-        break;
-      }
-      auto direction = predicate(current_2->forward[i]->key);
-      if (direction == 0)
-      {
-        current_2 = current_2->forward[i];
-        continue;
-      }
-      else if (direction < 0)
-      {
-        // 需要更小的步长
-        break;
-      }
-      else
-      {
-        throw std::runtime_error("iters_monotony_predicate error: invalid direction");
-      }
-    }
-  }
-  end_iter = SkipListIterator(current_2);
-  ++end_iter;
+  SkipListIterator begin_iter(first, arena);
+  SkipListIterator end_iter(skip_deleted(current->next(0)), arena);
 
   return std::make_optional(std::make_pair(begin_iter, end_iter));
-}
\ No newline at end of file
+}
@@ -0,0 +1,148 @@
+#include "../../include/sst/blob_file.h"
+#include "../../include/utils/buffer_pool.h"
+#include "../../include/utils/crc32c.h"
+#include "../../include/utils/varint.h"
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+static constexpr char BLOB_INLINE = 0x00;
+static constexpr char BLOB_REFERENCE = 0x01;
+
+bool BlobValue::need_escape(std::string_view value)
+{
+    return !value.empty() && value[0] == LSM_BLOB_VALUE_TAG;
+}
+
+std::string BlobValue::encode_inline(std::string_view value)
+{
+    if (!need_escape(value))
+    {
+        return std::string(value);
+    }
+    std::string res;
+    res.reserve(value.size() + 2);
+    res.push_back(LSM_BLOB_VALUE_TAG);
+    res.push_back(BLOB_INLINE);
+    res.append(value);
+    return res;
+}
+
+std::string BlobValue::encode_index(const BlobIndex &index)
+{
+    uint8_t buf[2 + 10 * 3];
+    buf[0] = static_cast<uint8_t>(LSM_BLOB_VALUE_TAG);
+    buf[1] = static_cast<uint8_t>(BLOB_REFERENCE);
+    uint8_t *p = buf + 2;
+    p = encode_varint(p, index.file_id);
+    p = encode_varint(p, index.offset);
+    p = encode_varint(p, index.size);
+    return std::string(reinterpret_cast<const char *>(buf), p - buf);
+}
+
+bool BlobValue::decode_index(std::string_view stored, BlobIndex &index)
+{
+    if (stored.size() < 2 || stored[0] != LSM_BLOB_VALUE_TAG || stored[1] != BLOB_REFERENCE)
+    {
+        return false;
+    }
+    auto p = reinterpret_cast<const uint8_t *>(stored.data()) + 2;
+    auto limit = reinterpret_cast<const uint8_t *>(stored.data()) + stored.size();
+    uint64_t file_id;
+    if ((p = decode_varint(p, limit, file_id)) == nullptr ||
+        (p = decode_varint(p, limit, index.offset)) == nullptr ||
+        (p = decode_varint(p, limit, index.size)) == nullptr || p != limit)
+    {
+        throw std::runtime_error("Corrupted blob index");
+    }
+    index.file_id = file_id;
+    return true;
+}
+
+std::string_view BlobValue::decode_inline(std::string_view stored)
+{
+    if (!need_escape(stored))
+    {
+        return stored;
+    }
+    if (stored.size() < 2 || stored[1] != BLOB_INLINE)
+    {
+        throw std::runtime_error("Corrupted escaped value");
+    }
+    return stored.substr(2);
+}
+
+std::shared_ptr<BlobFile> BlobFile::create(size_t file_id, const std::string &path)
+{
+    auto blob = std::make_shared<BlobFile>();
+    blob->file = FileObj::open(path, true);
+    blob->file_id = file_id;
+    blob->file_size = 0;
+    return blob;
+}
+
+std::shared_ptr<BlobFile> BlobFile::open(size_t file_id, const std::string &path)
+{
+    auto blob = std::make_shared<BlobFile>();
+    blob->file = FileObj::open(path, false);
+    blob->file_id = file_id;
+    blob->file_size = blob->file.size();
+    return blob;
+}
+
+BlobIndex BlobFile::append(std::string_view value)
+{
+    std::vector<uint8_t> record(value.size() + sizeof(uint32_t));
+    memcpy(record.data(), value.data(), value.size());
+    uint32_t crc = crc32c(value.data(), value.size());
+    memcpy(record.data() + value.size(), &crc, sizeof(uint32_t));
+
+    std::lock_guard<std::mutex> lock(mtx);
+    BlobIndex index{file_id, file_size, value.size()};
+    if (!file.write(file_size, record))
+    {
+        throw std::runtime_error("Failed to write blob file");
+    }
+    file_size += record.size();
+    return index;
+}
+
+std::string BlobFile::read(const BlobIndex &index)
+{
+    std::vector<uint8_t> record;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (index.offset + index.size + sizeof(uint32_t) > file_size)
+        {
+            throw std::runtime_error("Blob index out of range");
+        }
+        record = file.read_to_slice(index.offset, index.size + sizeof(uint32_t));
+    }
+
+    uint32_t crc;
+    memcpy(&crc, record.data() + index.size, sizeof(uint32_t));
+    if (crc != crc32c(record.data(), index.size))
+    {
+        throw std::runtime_error("Blob checksum mismatch");
+    }
+    std::string value(reinterpret_cast<const char *>(record.data()), index.size);
+    BufferPool::global().release(std::move(record));
+    return value;
+}
+
+size_t BlobFile::get_file_id() const
+{
+    return file_id;
+}
+
+size_t BlobFile::size()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return file_size;
+}
+
+void BlobFile::del_file()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    file.del_file();
+}
@@ -0,0 +1,120 @@
+#include "../../include/sst/blob_store.h"
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+BlobStore::BlobStore(std::string data_dir, size_t max_file_size)
+    : data_dir(std::move(data_dir)), max_file_size(max_file_size)
+{
+    if (!std::filesystem::exists(this->data_dir))
+    {
+        return;
+    }
+    for (auto &entry : std::filesystem::directory_iterator(this->data_dir))
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+        // blob_{id}
+        std::string filename = entry.path().filename().string();
+        if (filename.substr(0, 5) != "blob_" || filename.size() == 5)
+        {
+            continue;
+        }
+        size_t file_id = std::stoull(filename.substr(5));
+        files[file_id] = BlobFile::open(file_id, entry.path().string());
+        next_file_id = std::max(next_file_id, file_id + 1);
+    }
+}
+
+std::string BlobStore::get_blob_path(size_t file_id)
+{
+    std::stringstream ss;
+    ss << data_dir << "/blob_" << std::setfill('0') << std::setw(4) << file_id;
+    return ss.str();
+}
+
+std::shared_ptr<BlobFile> BlobStore::get_file(size_t file_id)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = files.find(file_id);
+    if (it == files.end())
+    {
+        throw std::runtime_error("Blob file not found");
+    }
+    return it->second;
+}
+
+BlobIndex BlobStore::add(std::string_view value)
+{
+    std::shared_ptr<BlobFile> file;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (active == nullptr || active->size() >= max_file_size)
+        {
+            size_t file_id = next_file_id++;
+            active = BlobFile::create(file_id, get_blob_path(file_id));
+            files[file_id] = active;
+        }
+        file = active;
+    }
+    return file->append(value);
+}
+
+std::string BlobStore::get(const BlobIndex &index)
+{
+    return get_file(index.file_id)->read(index);
+}
+
+std::string BlobStore::resolve(std::string_view stored)
+{
+    BlobIndex index;
+    if (BlobValue::decode_index(stored, index))
+    {
+        return get(index);
+    }
+    return std::string(BlobValue::decode_inline(stored));
+}
+
+bool BlobStore::need_relocate(size_t file_id)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = files.find(file_id);
+    if (it == files.end() || it->second == active)
+    {
+        return false;
+    }
+    // 上次统计之后才写满的文件还没有存活数据的统计，不搬运
+    auto live = live_bytes.find(file_id);
+    if (live == live_bytes.end())
+    {
+        return false;
+    }
+    return live->second < it->second->size() * LSM_BLOB_GC_RATIO;
+}
+
+void BlobStore::collect_garbage(const std::unordered_map<size_t, uint64_t> &live)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    live_bytes = live;
+    for (auto it = files.begin(); it != files.end();)
+    {
+        if (it->second != active && live_bytes.find(it->first) == live_bytes.end())
+        {
+            it->second->del_file();
+            it = files.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+size_t BlobStore::file_count()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return files.size();
+}
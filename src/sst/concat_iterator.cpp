@@ -52,6 +52,6 @@ bool ConcatIterator::is_valid() const {
   return cur_iter.is_valid() && cur_idx < ssts_.size();
 }
 
-uint64_t ConcatIterator::get_tranc_id() const { 
-  return max_tranc_id_; 
+uint64_t ConcatIterator::get_tranc_id() const {
+  return cur_iter.get_tranc_id();
 }
\ No newline at end of file
@@ -1,19 +1,74 @@
 #include "../../include/sst/sst.h"
 #include "../../include/const.h"
+#include "../../include/utils/varint.h"
+#include <algorithm>
 
-SSTBuilder::SSTBuilder(size_t block_size, bool with_bloom) : block_size(block_size), block(block_size)
+SSTBuilder::SSTBuilder(size_t block_size, bool with_bloom, CompressionType compression)
+    : block_size(block_size), block(block_size, LSM_BLOCK_HASH_INDEX), compression(compression),
+      index_partition_size(LSM_SST_INDEX_PARTITION_SIZE), index_partition(LSM_SST_INDEX_PARTITION_SIZE)
 {
     if (with_bloom)
     {
         this->bloom_filter = std::make_shared<BloomFilter>(BLOOM_FILTER_EXPEXTED_SIZE, BLOOM_FILTER_EXPEXTED_ERROR_RATE);
     }
-    meta_entries.clear();
     data.clear();
     first_key.clear();
     last_key.clear();
 }
 
-void SSTBuilder::add(const std::string &key, const std::string &value, uint64_t tranc_id)
+void SSTBuilder::set_blob_store(std::shared_ptr<BlobStore> store)
+{
+    blob_store = std::move(store);
+}
+
+void SSTBuilder::set_index_partition_size(size_t size)
+{
+    if (indexed_blocks > 0)
+    {
+        throw std::runtime_error("Index partition size must be set before adding data");
+    }
+    index_partition_size = size;
+    index_partition = Block(size);
+}
+
+void SSTBuilder::add(std::string_view key, std::string_view value, uint64_t tranc_id)
+{
+    if (blob_store != nullptr && value.size() >= LSM_BLOB_VALUE_THRESHOLD)
+    {
+        auto index = blob_store->add(value);
+        blob_refs[index.file_id] += index.size;
+        add_entry(key, BlobValue::encode_index(index), tranc_id);
+    }
+    else if (BlobValue::need_escape(value))
+    {
+        add_entry(key, BlobValue::encode_inline(value), tranc_id);
+    }
+    else
+    {
+        add_entry(key, value, tranc_id);
+    }
+}
+
+void SSTBuilder::add_encoded(std::string_view key, std::string_view stored_value, uint64_t tranc_id)
+{
+    BlobIndex index;
+    if (!BlobValue::decode_index(stored_value, index))
+    {
+        add_entry(key, stored_value, tranc_id);
+        return;
+    }
+    if (blob_store != nullptr && blob_store->need_relocate(index.file_id))
+    {
+        index = blob_store->add(blob_store->get(index));
+        blob_refs[index.file_id] += index.size;
+        add_entry(key, BlobValue::encode_index(index), tranc_id);
+        return;
+    }
+    blob_refs[index.file_id] += index.size;
+    add_entry(key, stored_value, tranc_id);
+}
+
+void SSTBuilder::add_entry(std::string_view key, std::string_view value, uint64_t tranc_id)
 {
     if (first_key.empty())
     {
@@ -32,46 +87,83 @@ void SSTBuilder::add(const std::string &key, const std::string &value, uint64_t
     bool force_write = last_key == key;
     // 连续出现的相同的key必须位于同一个block
 
-    if (block.add_entry(key, value, tranc_id, force_write))
+    if (!block.add_entry(key, value, tranc_id, force_write))
     {
-        last_key = key;
-        return;
+        finish_block();
+        block.add_entry(key, value, tranc_id, force_write);
     }
 
-    finish_block();
-
-    block.add_entry(key, value, tranc_id, force_write);
-    first_key = key;
+    // 新 block 的第一个 key 确定了上一个 block 的分隔 key
+    if (pending_meta.has_value())
+    {
+        add_index_entry(BlockMeta::shortest_separator(pending_last_key, key), *pending_meta);
+        pending_meta.reset();
+    }
     last_key = key;
 }
 
 size_t SSTBuilder::estimated_size() const
 {
-    return data.size();
+    // 包括还没有写完的 block，否则不足一个 block 的数据会被当成空的
+    return block.is_empty() ? data.size() : data.size() + block.cur_size();
+}
+
+BlockMeta SSTBuilder::write_block(const std::vector<uint8_t> &encoded, CompressionType type, std::vector<uint8_t> &out)
+{
+    // 每个 block 在文件中的格式：| block(可能被压缩) | 压缩类型(uint8_t) | CRC32C(uint32_t) |
+    // 压缩后没有变小的 block 按原样写入
+    size_t block_start = out.size();
+    auto used = Compression::compress(type, encoded.data(), encoded.size(), out);
+    if (used == CompressionType::None)
+    {
+        out.insert(out.end(), encoded.begin(), encoded.end());
+    }
+    out.push_back(static_cast<uint8_t>(used));
+
+    // 计算校验值，覆盖 block 和压缩类型
+    uint32_t block_crc = crc32c(out.data() + block_start, out.size() - block_start);
+
+    out.resize(out.size() + sizeof(uint32_t));
+    memcpy(out.data() + out.size() - sizeof(uint32_t), &block_crc,
+           sizeof(uint32_t));
+    return BlockMeta(block_start, out.size() - block_start);
 }
 
 void SSTBuilder::finish_block()
 {
     // 将block编码data中
     auto old_block = std::move(this->block);
+    this->block = Block(block_size, LSM_BLOCK_HASH_INDEX);
     auto encoded_block = old_block.encode();
 
-    // 把block的元数据也写入
-    meta_entries.emplace_back(data.size(), first_key, last_key);
+    // 分隔 key 要等下一个 block 的第一个 key 确定后才能写入索引
+    pending_meta = write_block(encoded_block, compression, data);
+    pending_last_key = last_key;
+    num_blocks++;
+}
 
-    // 计算哈希校验值
-    auto block_hash = static_cast<uint32_t>(std::hash<std::string_view>{}(
-        std::string_view(reinterpret_cast<const char *>(encoded_block.data()),
-                         encoded_block.size())));
+void SSTBuilder::add_index_entry(const std::string &separator, const BlockMeta &meta)
+{
+    std::string value;
+    meta.encode_to(value);
 
-    //  预分配空间并添加数据
-    data.reserve(data.size() + encoded_block.size() +
-                 sizeof(uint32_t)); // uint32_t 是表示的哈希值
+    // 不分区时所有记录都写入同一个索引块
+    bool force_write = index_partition_size == 0;
+    if (!index_partition.add_entry(separator, value, 0, force_write))
+    {
+        finish_index_partition();
+        index_partition.add_entry(separator, value, 0, force_write);
+    }
+    last_separator = separator;
+    indexed_blocks++;
+}
 
-    data.insert(data.end(), encoded_block.begin(), encoded_block.end());
-    data.resize(data.size() + sizeof(uint32_t));
-    memcpy(data.data() + data.size() - sizeof(uint32_t), &block_hash,
-           sizeof(uint32_t));
+void SSTBuilder::finish_index_partition()
+{
+    auto old_partition = std::move(index_partition);
+    index_partition = Block(index_partition_size);
+    index_partitions.push_back({old_partition.encode(), last_separator, partition_first_block});
+    partition_first_block = indexed_blocks;
 }
 
 std::shared_ptr<SST>
@@ -84,26 +176,68 @@ SSTBuilder::build(size_t sst_id, const std::string &path,
     }
 
     // 判断是否有数据
-    if (meta_entries.empty())
+    if (num_blocks == 0)
     {
         throw std::runtime_error("No data to build SST");
     }
 
-    // 编码元数据块
-    std::vector<uint8_t> meta_block;
-    BlockMeta::encode_meta_to_slice(meta_entries, meta_block);
-
-    // 计算元数据块的偏移量
-    uint32_t meta_offset = data.size();
+    // 最后一个 block 没有后继，用 last_key 的短后继作为分隔 key
+    if (pending_meta.has_value())
+    {
+        add_index_entry(BlockMeta::shortest_successor(pending_last_key), *pending_meta);
+        pending_meta.reset();
+    }
+    if (!index_partition.is_empty())
+    {
+        finish_index_partition();
+    }
 
     // 构建文件内容
     // 1. 写入数据块
     std::vector<uint8_t> file_content = std::move(data);
 
-    // 2. 写入元数据块
-    file_content.insert(file_content.end(), meta_block.begin(), meta_block.end());
+    // 2. 写入索引：只有一个分区时它就是单层索引，否则先写入各个分区，顶层索引指向分区
+    // 顶层索引中分区的 value：| offset(varint) | size(varint) | 第一个数据块的编号(varint) |
+    std::vector<uint8_t> top_index;
+    std::vector<BlockMeta> partition_metas;
+    std::vector<uint32_t> partition_first_blocks;
+    if (index_partitions.size() == 1)
+    {
+        top_index = std::move(index_partitions.front().encoded);
+    }
+    else
+    {
+        Block top(0);
+        for (auto &partition : index_partitions)
+        {
+            auto meta = write_block(partition.encoded, CompressionType::None, file_content);
+            std::string value;
+            meta.encode_to(value);
+            uint8_t buf[10];
+            value.append(reinterpret_cast<const char *>(buf), encode_varint(buf, partition.first_block) - buf);
+            top.add_entry(partition.last_separator, value, 0, true);
+            partition_metas.push_back(meta);
+            partition_first_blocks.push_back(partition.first_block);
+        }
+        top_index = top.encode();
+    }
 
-    // 3. 需要写入布隆过滤器
+    // 3. 写入元数据块：
+    // | 数据块数量(varint) | 索引分区数量(varint，0 表示单层索引) | first_key 长度(varint) | first_key |
+    // | last_key 长度(varint) | last_key | CRC32C(uint32_t) | 顶层索引块(带压缩类型和校验值) |
+    uint32_t meta_offset = file_content.size();
+    put_varint(file_content, num_blocks);
+    put_varint(file_content, partition_metas.size());
+    put_varint(file_content, first_key.size());
+    file_content.insert(file_content.end(), first_key.begin(), first_key.end());
+    put_varint(file_content, last_key.size());
+    file_content.insert(file_content.end(), last_key.begin(), last_key.end());
+    uint32_t meta_crc = crc32c(file_content.data() + meta_offset, file_content.size() - meta_offset);
+    file_content.resize(file_content.size() + sizeof(uint32_t));
+    memcpy(file_content.data() + file_content.size() - sizeof(uint32_t), &meta_crc, sizeof(uint32_t));
+    write_block(top_index, CompressionType::None, file_content);
+
+    // 4. 需要写入布隆过滤器
     uint32_t bloom_offset = file_content.size();
     if (this->bloom_filter != nullptr)
     {
@@ -111,17 +245,33 @@ SSTBuilder::build(size_t sst_id, const std::string &path,
         file_content.insert(file_content.end(), bf_data.begin(), bf_data.end());
     }
 
-    file_content.resize(file_content.size() + sizeof(uint32_t) * 2 + sizeof(uint64_t) * 2);
+    // 5. 写入 blob 引用统计：| 文件数 varint | (file_id varint | 字节数 varint) ... | CRC32C(uint32_t) |
+    uint32_t blob_offset = file_content.size();
+    put_varint(file_content, blob_refs.size());
+    for (auto &[file_id, bytes] : blob_refs)
+    {
+        put_varint(file_content, file_id);
+        put_varint(file_content, bytes);
+    }
+    uint32_t blob_crc = crc32c(file_content.data() + blob_offset, file_content.size() - blob_offset);
+    file_content.resize(file_content.size() + sizeof(uint32_t));
+    memcpy(file_content.data() + file_content.size() - sizeof(uint32_t), &blob_crc, sizeof(uint32_t));
 
-    // 4. 编码meta section的offset
-    memcpy(file_content.data() + file_content.size() - sizeof(uint32_t) * 2 - sizeof(uint64_t) * 2,
+    file_content.resize(file_content.size() + sizeof(uint32_t) * 3 + sizeof(uint64_t) * 2);
+
+    // 6. 编码meta section的offset
+    memcpy(file_content.data() + file_content.size() - sizeof(uint32_t) * 3 - sizeof(uint64_t) * 2,
            &meta_offset, sizeof(uint32_t));
 
-    // 5. 编码bloom section的offset
-    memcpy(file_content.data() + file_content.size() - sizeof(uint32_t) * 2,
+    // 7. 编码bloom section的offset
+    memcpy(file_content.data() + file_content.size() - sizeof(uint32_t) * 2 - sizeof(uint64_t) * 2,
            &bloom_offset, sizeof(uint32_t));
 
-    // 6. 记录最大最小事务id信息
+    // 8. 编码blob section的offset
+    memcpy(file_content.data() + file_content.size() - sizeof(uint32_t) - sizeof(uint64_t) * 2,
+           &blob_offset, sizeof(uint32_t));
+
+    // 9. 记录最大最小事务id信息
     memcpy(file_content.data() + file_content.size() - sizeof(uint64_t) * 2,
            &min_tranc_id_, sizeof(uint64_t));
     memcpy(file_content.data() + file_content.size() - sizeof(uint64_t),
@@ -133,9 +283,12 @@ SSTBuilder::build(size_t sst_id, const std::string &path,
 
     res->sst_id = sst_id;
     res->file = std::move(file);
-    res->first_key = meta_entries.front().first_key;
-    res->last_key = meta_entries.back().last_key;
-    res->meta_entries = std::move(meta_entries);
+    res->first_key = first_key;
+    res->last_key = last_key;
+    res->num_data_blocks = num_blocks;
+    res->index_block = Block::decode(std::move(top_index));
+    res->partition_metas = std::move(partition_metas);
+    res->partition_first_block = std::move(partition_first_blocks);
     res->bloom_filter = this->bloom_filter;
     res->bloom_offset = bloom_offset;
     res->meta_block_offset = meta_offset;
@@ -143,39 +296,96 @@ SSTBuilder::build(size_t sst_id, const std::string &path,
 
     res->min_tranc_id_ = min_tranc_id_;
     res->max_tranc_id_ = max_tranc_id_;
+    res->blob_refs = std::move(blob_refs);
 
     return res;
 }
 
-SstIterator SST::get(const std::string &key, uint64_t tranc_id)
+SstIterator SST::get(const std::string &key, uint64_t tranc_id, const ReadOptions &options)
 {
     // 在布隆过滤器判断key是否存在
     if (bloom_filter != nullptr && !bloom_filter->possibly_contains(key))
     {
         return this->end(tranc_id);
     }
-    return SstIterator(shared_from_this(), key, tranc_id);
+    return SstIterator(shared_from_this(), key, tranc_id, options);
 }
 
 size_t SST::num_blocks()
 {
-    return meta_entries.size();
+    return num_data_blocks;
 }
 
-SstIterator SST::begin(uint64_t tranc_id)
+SstIterator SST::begin(uint64_t tranc_id, const ReadOptions &options)
 {
-    return SstIterator(shared_from_this(), tranc_id);
+    return SstIterator(shared_from_this(), tranc_id, options);
 }
 
 SstIterator SST::end(uint64_t tranc_id)
 {
-    auto res = SstIterator(shared_from_this(), tranc_id);
-    res.m_sst = nullptr;
+    // 不关联 SST 构造，不会读取任何 block
+    auto res = SstIterator(nullptr, tranc_id);
     res.m_block_idx = -1;
-    res.cached_value = std::nullopt;
     return res;
 }
 
+static std::unordered_map<size_t, uint64_t> decode_blob_refs(const std::vector<uint8_t> &bytes)
+{
+    if (bytes.size() < sizeof(uint32_t))
+    {
+        throw std::runtime_error("Invalid blob refs section");
+    }
+    size_t body_size = bytes.size() - sizeof(uint32_t);
+    uint32_t crc;
+    memcpy(&crc, bytes.data() + body_size, sizeof(uint32_t));
+    if (crc != crc32c(bytes.data(), body_size))
+    {
+        throw std::runtime_error("Blob refs checksum mismatch");
+    }
+
+    std::unordered_map<size_t, uint64_t> refs;
+    const uint8_t *p = bytes.data();
+    const uint8_t *limit = p + body_size;
+    uint64_t count;
+    if ((p = decode_varint(p, limit, count)) == nullptr)
+    {
+        throw std::runtime_error("Invalid blob refs section");
+    }
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uint64_t file_id, file_bytes;
+        if ((p = decode_varint(p, limit, file_id)) == nullptr ||
+            (p = decode_varint(p, limit, file_bytes)) == nullptr)
+        {
+            throw std::runtime_error("Invalid blob refs section");
+        }
+        refs[file_id] = file_bytes;
+    }
+    return refs;
+}
+
+std::unordered_map<size_t, uint64_t> SST::read_blob_refs(FileObj &file)
+{
+    const size_t footer_size = sizeof(uint32_t) * 3 + sizeof(uint64_t) * 2;
+    size_t file_size = file.size();
+    if (file_size < footer_size)
+    {
+        throw std::runtime_error("File size is too small");
+    }
+
+    auto footer = file.read_to_slice(file_size - footer_size, sizeof(uint32_t) * 3);
+    uint32_t bloom_offset, blob_offset;
+    memcpy(&bloom_offset, footer.data() + sizeof(uint32_t), sizeof(uint32_t));
+    memcpy(&blob_offset, footer.data() + sizeof(uint32_t) * 2, sizeof(uint32_t));
+    if (bloom_offset > blob_offset || blob_offset + sizeof(uint32_t) > file_size - footer_size)
+    {
+        throw std::runtime_error("Invalid SST footer");
+    }
+
+    auto blob_bytes = file.read_to_slice(blob_offset, file_size - footer_size - blob_offset);
+    return decode_blob_refs(blob_bytes);
+}
+
 std::shared_ptr<SST> SST::open(size_t sst_id, FileObj file,
                                std::shared_ptr<BlockCache> cache)
 {
@@ -185,51 +395,124 @@ std::shared_ptr<SST> SST::open(size_t sst_id, FileObj file,
     sst->cache = cache;
 
     // 读取文件末尾的元数据块
-    // 1. 读取偏移量
+    // | ... | meta_offset(uint32_t) | bloom_offset(uint32_t) | blob_offset(uint32_t) | min_tranc_id(uint64_t) | max_tranc_id(uint64_t) |
+    // 1. 读取偏移量和事务id范围
+    const size_t footer_size = sizeof(uint32_t) * 3 + sizeof(uint64_t) * 2;
     size_t file_size = sst->file.size();
-    if (file_size < sizeof(uint32_t))
+    if (file_size < footer_size)
     {
         throw std::runtime_error("File size is too small");
     }
 
-    auto bloom_offset_bytes =
-        sst->file.read_to_slice(file_size - sizeof(uint32_t), sizeof(uint32_t));
-    memcpy(&sst->bloom_offset, bloom_offset_bytes.data(), sizeof(uint32_t));
+    auto footer = sst->file.read_to_slice(file_size - footer_size, footer_size);
+    memcpy(&sst->meta_block_offset, footer.data(), sizeof(uint32_t));
+    memcpy(&sst->bloom_offset, footer.data() + sizeof(uint32_t), sizeof(uint32_t));
+    uint32_t blob_offset;
+    memcpy(&blob_offset, footer.data() + sizeof(uint32_t) * 2, sizeof(uint32_t));
+    memcpy(&sst->min_tranc_id_, footer.data() + sizeof(uint32_t) * 3, sizeof(uint64_t));
+    memcpy(&sst->max_tranc_id_, footer.data() + sizeof(uint32_t) * 3 + sizeof(uint64_t), sizeof(uint64_t));
+    if (sst->meta_block_offset > sst->bloom_offset || sst->bloom_offset > blob_offset ||
+        blob_offset + sizeof(uint32_t) > file_size - footer_size)
+    {
+        throw std::runtime_error("Invalid SST footer");
+    }
 
-    auto meta_offset_bytes = sst->file.read_to_slice(
-        file_size - sizeof(uint32_t) * 2, sizeof(uint32_t));
-    memcpy(&sst->meta_block_offset, meta_offset_bytes.data(), sizeof(uint32_t));
+    // 2. 读取 blob 引用统计
+    auto blob_bytes = sst->file.read_to_slice(blob_offset, file_size - footer_size - blob_offset);
+    sst->blob_refs = decode_blob_refs(blob_bytes);
 
-    // 2. 读取 bloom filter
-    if (sst->bloom_offset + 2 * sizeof(uint32_t) < file_size)
+    // 3. 读取 bloom filter
+    if (sst->bloom_offset < blob_offset)
     {
-        // 布隆过滤器偏移量 + 2*uint32_t 的大小小于文件大小
-        // 表示存在布隆过滤器
-        uint32_t bloom_size = file_size - sst->bloom_offset - sizeof(uint32_t) * 2;
+        // 布隆过滤器和 blob 引用统计之间还有数据，表示存在布隆过滤器
+        uint32_t bloom_size = blob_offset - sst->bloom_offset;
         auto bloom_bytes = sst->file.read_to_slice(sst->bloom_offset, bloom_size);
 
         auto bloom = BloomFilter::decode(bloom_bytes);
         sst->bloom_filter = std::make_shared<BloomFilter>(std::move(bloom));
     }
 
-    // 3. 读取并解码元数据块
+    // 4. 读取元数据块
+    // | 数据块数量 | 索引分区数量 | first_key 长度 | first_key | last_key 长度 | last_key | CRC32C | 顶层索引块 |
     uint32_t meta_size = sst->bloom_offset - sst->meta_block_offset;
     auto meta_bytes = sst->file.read_to_slice(sst->meta_block_offset, meta_size);
-    sst->meta_entries = BlockMeta::decode_meta_from_slice(meta_bytes);
+    const uint8_t *p = meta_bytes.data();
+    const uint8_t *limit = p + meta_bytes.size();
+    uint64_t num_blocks, num_partitions, first_key_len, last_key_len;
+    if ((p = decode_varint(p, limit, num_blocks)) == nullptr ||
+        (p = decode_varint(p, limit, num_partitions)) == nullptr ||
+        (p = decode_varint(p, limit, first_key_len)) == nullptr ||
+        static_cast<uint64_t>(limit - p) < first_key_len)
+    {
+        throw std::runtime_error("Invalid SST meta section");
+    }
+    sst->first_key.assign(reinterpret_cast<const char *>(p), first_key_len);
+    p += first_key_len;
+    if ((p = decode_varint(p, limit, last_key_len)) == nullptr ||
+        static_cast<uint64_t>(limit - p) < last_key_len + sizeof(uint32_t))
+    {
+        throw std::runtime_error("Invalid SST meta section");
+    }
+    sst->last_key.assign(reinterpret_cast<const char *>(p), last_key_len);
+    p += last_key_len;
 
-    // 4. 设置首尾key
-    if (!sst->meta_entries.empty())
+    uint32_t meta_crc;
+    memcpy(&meta_crc, p, sizeof(uint32_t));
+    if (meta_crc != crc32c(meta_bytes.data(), p - meta_bytes.data()))
     {
-        sst->first_key = sst->meta_entries.front().first_key;
-        sst->last_key = sst->meta_entries.back().last_key;
+        throw std::runtime_error("Meta section checksum mismatch");
     }
+    p += sizeof(uint32_t);
+
+    // 5. 解码顶层索引块
+    std::vector<uint8_t> top_index(p, limit);
+    sst->num_data_blocks = num_blocks;
+    sst->set_index(Block::decode(unpack_block(std::move(top_index), true)), num_partitions);
 
     return sst;
 }
 
+void SST::set_index(std::shared_ptr<Block> top_index, size_t num_partitions)
+{
+    index_block = std::move(top_index);
+    partition_metas.clear();
+    partition_first_block.clear();
+    if (num_partitions == 0)
+    {
+        if (index_block->size() != num_data_blocks)
+        {
+            throw std::runtime_error("Invalid SST index");
+        }
+        return;
+    }
+
+    if (index_block->size() != num_partitions)
+    {
+        throw std::runtime_error("Invalid SST index");
+    }
+    for (size_t i = 0; i < num_partitions; i++)
+    {
+        BlockMeta meta;
+        auto rest = BlockMeta::decode_from(index_block->value_at(i), meta);
+        uint64_t first_block;
+        auto begin = reinterpret_cast<const uint8_t *>(rest.data());
+        if (decode_varint(begin, begin + rest.size(), first_block) == nullptr || first_block >= num_data_blocks)
+        {
+            throw std::runtime_error("Invalid SST index");
+        }
+        partition_metas.push_back(meta);
+        partition_first_block.push_back(first_block);
+    }
+}
+
 std::shared_ptr<Block> SST::read_block(size_t block_idx)
 {
-    if (block_idx >= meta_entries.size())
+    return read_block(block_idx, LSM_VERIFY_CHECKSUMS);
+}
+
+std::shared_ptr<Block> SST::read_block(size_t block_idx, bool verify_checksum)
+{
+    if (block_idx >= num_data_blocks)
     {
         throw std::runtime_error("Block index out of range");
     }
@@ -248,70 +531,147 @@ std::shared_ptr<Block> SST::read_block(size_t block_idx)
         throw std::runtime_error("Cache is nullptr");
     }
 
-    const auto &meta = meta_entries[block_idx];
-    size_t block_size;
+    // 读取block数据，解压后再放入缓存
+    auto block_res = load_block(get_block_meta(block_idx), verify_checksum);
+
+    // 更新缓存
+    cache->put(sst_id, block_idx, block_res);
 
-    // 计算block的大小
-    if (block_idx == meta_entries.size() - 1)
+    return block_res;
+}
+
+std::shared_ptr<Block> SST::load_block(const BlockMeta &meta, bool verify_checksum)
+{
+    if (meta.offset + meta.size > meta_block_offset)
     {
-        block_size = meta_block_offset - meta.offset;
+        throw std::runtime_error("Block meta out of range");
+    }
+    auto block_data = file.read_to_slice(meta.offset, meta.size);
+    return Block::decode(unpack_block(std::move(block_data), verify_checksum));
+}
+
+std::shared_ptr<Block> SST::read_index_partition(size_t partition_idx)
+{
+    // 索引分区和数据块共用 block cache，编号排在数据块之后
+    size_t cache_id = num_data_blocks + partition_idx;
+    if (cache != nullptr)
+    {
+        auto cached_block = cache->get(sst_id, cache_id);
+        if (cached_block != nullptr)
+        {
+            return cached_block;
+        }
     }
     else
     {
-        block_size = meta_entries[block_idx + 1].offset - meta.offset;
+        throw std::runtime_error("Cache is nullptr");
     }
 
-    // 读取block数据
-    auto block_data = file.read_to_slice(meta.offset, block_size);
-    auto block_res = Block::decode(block_data, true);
+    // 索引分区读取次数少且常驻缓存，总是按默认设置校验
+    auto partition = load_block(partition_metas[partition_idx], LSM_VERIFY_CHECKSUMS);
+    cache->put(sst_id, cache_id, partition);
+    return partition;
+}
 
-    // 更新缓存
-    if (cache != nullptr)
+BlockMeta SST::get_block_meta(size_t block_idx)
+{
+    BlockMeta meta;
+    if (partition_metas.empty())
     {
-        cache->put(sst_id, block_idx, block_res);
+        BlockMeta::decode_from(index_block->value_at(block_idx), meta);
+        return meta;
     }
-    else
+
+    // 找到包含该数据块的索引分区
+    auto it = std::upper_bound(partition_first_block.begin(), partition_first_block.end(), block_idx);
+    size_t partition_idx = it - partition_first_block.begin() - 1;
+    auto partition = read_index_partition(partition_idx);
+    BlockMeta::decode_from(partition->value_at(block_idx - partition_first_block[partition_idx]), meta);
+    return meta;
+}
+
+std::vector<uint8_t> SST::unpack_block(std::vector<uint8_t> raw, bool verify_checksum)
+{
+    if (raw.size() < sizeof(uint8_t) + sizeof(uint32_t))
     {
-        throw std::runtime_error("Cache is nullptr");
+        throw std::runtime_error("Invalid encoded block: size too small");
     }
 
-    return block_res;
+    size_t crc_pos = raw.size() - sizeof(uint32_t);
+    if (verify_checksum)
+    {
+        uint32_t stored_crc;
+        memcpy(&stored_crc, raw.data() + crc_pos, sizeof(uint32_t));
+        if (stored_crc != crc32c(raw.data(), crc_pos))
+        {
+            throw std::runtime_error("Invalid encoded block: checksum mismatch");
+        }
+    }
+
+    auto type = static_cast<CompressionType>(raw[crc_pos - 1]);
+    size_t block_len = crc_pos - 1;
+    if (type == CompressionType::None)
+    {
+        // 未压缩的 block 直接截掉尾部，不复制数据
+        raw.resize(block_len);
+        return raw;
+    }
+    auto block = Compression::decompress(type, raw.data(), block_len);
+    BufferPool::global().release(std::move(raw));
+    return block;
 }
 
 size_t SST::find_block_idx(const std::string &key)
 {
     // 先通过bloom filter判断
-    if (!bloom_filter && !bloom_filter->possibly_contains(key))
+    if (bloom_filter && !bloom_filter->possibly_contains(key))
     {
         return -1;
     }
 
-    // 二分查找
-    int left = 0, right = meta_entries.size() - 1;
-    while (left <= right)
+    // 分隔 key 满足 last_key(i) <= sep(i) < first_key(i + 1)，
+    // 第一个分隔 key 不小于 key 的 block 就是 key 可能所在的 block
+    std::string_view value;
+    size_t idx = index_block->lower_bound(key, value);
+    if (partition_metas.empty())
     {
-        int mid = left + (right - left) / 2;
-        const auto &meta = meta_entries[mid];
+        return idx >= num_data_blocks ? -1 : idx;
+    }
 
-        if (key < meta.first_key)
-        {
-            right = mid - 1;
-        }
-        else if (key > meta.last_key)
-        {
-            left = mid + 1;
-        }
-        else
-        {
-            return mid;
-        }
+    // 分区索引：先在顶层索引中找到分区，再在分区中查找
+    if (idx >= partition_metas.size())
+    {
+        return -1;
     }
-    if (left >= meta_entries.size())
+    auto partition = read_index_partition(idx);
+    size_t pos = partition->lower_bound(key, value);
+    if (pos >= partition->size())
     {
         return -1;
     }
+    return partition_first_block[idx] + pos;
+}
 
-    return left;
+size_t SST::find_block_partition_point(const std::function<bool(std::string_view)> &before)
+{
+    size_t idx = index_block->partition_point(before);
+    if (partition_metas.empty())
+    {
+        return idx;
+    }
+    if (idx >= partition_metas.size())
+    {
+        return num_data_blocks;
+    }
+    // 顶层索引中分区的 key 是分区内最后一个分隔 key，分区内一定能找到
+    auto partition = read_index_partition(idx);
+    return partition_first_block[idx] + partition->partition_point(before);
+}
+
+size_t SST::index_memory_size() const
+{
+    return index_block->cur_size() + partition_metas.size() * sizeof(BlockMeta) +
+           partition_first_block.size() * sizeof(uint32_t);
 }
 
 std::string SST::get_first_key()
@@ -339,6 +699,11 @@ std::pair<uint64_t, uint64_t> SST::get_tranc_id_range() const
     return std::make_pair(min_tranc_id_, max_tranc_id_);
 }
 
+const std::unordered_map<size_t, uint64_t> &SST::get_blob_refs() const
+{
+    return blob_refs;
+}
+
 void SST::del_sst()
 {
     file.del_file();
@@ -1,56 +1,71 @@
 #include "../../include/sst/sst_iterator.h"
 #include "../../include/sst/sst.h"
+#include <algorithm>
 #include <memory>
 
 // 谓词查询
-std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(uint64_t max_tranc_id, std::shared_ptr<SST> sst, std::function<int(const std::string &)> predicate)
+std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(uint64_t max_tranc_id, std::shared_ptr<SST> sst, std::function<int(const std::string &)> predicate, const ReadOptions &options)
 {
     // 初始化，分别用于存储最终的起始迭代器和结束迭代器。初始值为std::nullopt，表示尚未找到有效结果。
     std::optional<SstIterator> final_begin = std::nullopt;
     std::optional<SstIterator> final_end = std::nullopt;
 
-    // 遍历SST中的所有数据块，索引从0到sst->num_blocks() - 1。
-    for (int block_idx = 0; block_idx < sst->num_blocks(); block_idx++)
+    // predicate 返回值：>0 表示 key 在区间左侧，<0 表示 key 在区间右侧
+    // 整个 SST 都在区间之外时不读取任何 block
+    if (sst->num_blocks() == 0 || predicate(sst->get_last_key()) > 0 || predicate(sst->get_first_key()) < 0)
     {
-        auto block = sst->read_block(block_idx); // 读取索引为block_idx的数据块，返回一个指向该数据块的对象。
+        return std::nullopt;
+    }
 
-        BlockMeta &meta_i = sst->meta_entries[block_idx]; // 获取当前数据块的元信息（BlockMeta对象），包括该块的第一个键（first_key）和最后一个键（last_key）。
+    // 通过索引中的分隔 key 确定可能与区间重叠的数据块范围 [begin_block, end_block]：
+    // predicate(sep(i)) > 0 时 block i 的所有 key 都在区间左侧；
+    // predicate(sep(i)) < 0 时 block i 之后的所有 key 都在区间右侧
+    size_t begin_block = sst->find_block_partition_point([&](std::string_view sep)
+                                                         { return predicate(std::string(sep)) > 0; });
+    size_t end_block = sst->find_block_partition_point([&](std::string_view sep)
+                                                       { return predicate(std::string(sep)) >= 0; });
+    end_block = std::min(end_block, sst->num_blocks() - 1);
 
-        // 使用predicate函数对当前数据块的first_key和last_key进行评估。
-        // 排除不满足条件的数据块，减少不必要的计算。
-        if (predicate(meta_i.first_key) < 0 && predicate(meta_i.last_key) > 0)
-        {
-            continue;
-        }
+    // 直接构造指向指定位置的迭代器，不通过构造函数读取第一个 block
+    auto make_iter = [&](size_t block_idx, std::shared_ptr<BlockIterator> block_it)
+    {
+        SstIterator it(nullptr, max_tranc_id, options);
+        it.m_sst = sst;
+        it.m_block_idx = block_idx;
+        it.m_block_iter = std::move(block_it);
+        return it;
+    };
+
+    for (size_t block_idx = begin_block; block_idx <= end_block; block_idx++)
+    {
+        auto block = sst->read_block(block_idx, options.verify_checksums); // 读取索引为block_idx的数据块，返回一个指向该数据块的对象。
 
         // 对当前数据块执行谓词查询，返回一个std::optional对象，包含一对BlockIterator（起始迭代器和结束迭代器）。
         auto result_i = block->get_monotony_predicate(max_tranc_id, predicate);
 
-        if (result_i.has_value())
+        if (!result_i.has_value())
         {
-            auto [i_begin, i_end] = result_i.value();
-
-            if (!final_begin.has_value())
+            if (final_begin.has_value())
             {
-                // 如果final_begin尚未设置（即第一次找到满足条件的结果），创建一个新的SstIterator对象temp_it。
-                // 置temp_it的块索引为block_idx，并将其块内迭代器设置为i_begin。
-                // 将temp_it赋值给final_begin。
-
-                auto temp_it = SstIterator(sst, max_tranc_id);
-                temp_it.set_block_idx(block_idx);
-                temp_it.set_block_it(i_begin);
-                final_begin = temp_it;
+                // 已经找到的区间在上一个 block 的末尾结束
+                break;
             }
+            continue;
+        }
 
-            // 设置结束迭代器
-            auto temp_it = SstIterator(sst, max_tranc_id);
-            temp_it.set_block_idx(block_idx);
-            temp_it.set_block_it(i_end);
-            if (!temp_it.is_valid())
-            {
-                temp_it.set_block_it(nullptr); // temp_it无效，则将其块内迭代器设置为nullptr。
-            }
-            final_end = temp_it; // 将temp_it赋值给final_end。
+        auto [i_begin, i_end] = result_i.value();
+        if (!final_begin.has_value())
+        {
+            // 第一次找到满足条件的结果，起始迭代器指向这个 block 中的 i_begin
+            final_begin = make_iter(block_idx, i_begin);
+        }
+
+        // 结束位置可能是 block 的末尾，和下一个 block 的开头比较时相等，不需要提前读取下一个 block
+        final_end = make_iter(block_idx, i_end);
+        if (i_end->is_valid())
+        {
+            // 区间在这个 block 内结束，后面的 block 不用再读取
+            break;
         }
     }
 
@@ -61,7 +76,17 @@ std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(
     return std::make_pair(final_begin.value(), final_end.value());
 }
 
-SstIterator::SstIterator(std::shared_ptr<SST> sst, const std::string &key, uint64_t max_tranc_id) : m_sst(std::move(sst)), cached_value(std::nullopt), max_tranc_id_(max_tranc_id)
+SstIterator::SstIterator(std::shared_ptr<SST> sst, uint64_t max_tranc_id, const ReadOptions &options)
+    : m_sst(std::move(sst)), m_block_idx(0), cached_value(std::nullopt), max_tranc_id_(max_tranc_id), options_(options)
+{
+    if (m_sst && m_sst->num_blocks() > 0)
+    {
+        m_block_iter = std::make_shared<BlockIterator>(m_sst->read_block(0, options_.verify_checksums), 0, max_tranc_id_);
+    }
+}
+
+SstIterator::SstIterator(std::shared_ptr<SST> sst, const std::string &key, uint64_t max_tranc_id, const ReadOptions &options)
+    : m_sst(std::move(sst)), cached_value(std::nullopt), max_tranc_id_(max_tranc_id), options_(options)
 {
     if (m_sst)
     {
@@ -97,7 +122,7 @@ void SstIterator::seek(const std::string &key)
             m_block_idx = m_sst->num_blocks();
             return;
         }
-        auto block = m_sst->read_block(m_block_idx);
+        auto block = m_sst->read_block(m_block_idx, options_.verify_checksums);
         if (!block)
         {
             m_block_iter = nullptr;
@@ -125,7 +150,8 @@ BaseIterator &SstIterator::operator++()
         throw std::runtime_error("Block iterator in Sstiterator is null");
     }
 
-    // 1.先自增block
+    // 1.先自增block，之前缓存的当前记录失效
+    cached_value = std::nullopt;
     ++(*m_block_iter);
 
     // 2.需要判断自增后是否end了
@@ -135,7 +161,7 @@ BaseIterator &SstIterator::operator++()
         m_block_idx++;
         if (m_block_idx < m_sst->num_blocks())
         {
-            auto new_block = m_sst->read_block(m_block_idx);
+            auto new_block = m_sst->read_block(m_block_idx, options_.verify_checksums);
             BlockIterator new_blk_it(new_block, 0, max_tranc_id_);
             (*m_block_iter) = new_blk_it;
         }
@@ -167,17 +193,29 @@ bool SstIterator::operator==(const BaseIterator &other) const
     {
         return false;
     }
-    auto other2 = dynamic_cast<const SstIterator &>(other);
-    if (m_sst != other2.m_sst || m_block_idx != other2.m_block_idx)
+    auto &other2 = dynamic_cast<const SstIterator &>(other);
+    if (m_sst != other2.m_sst)
     {
         return false;
     }
-    if (!m_block_iter && !other2.m_block_iter)
+    if (!m_sst)
     {
-        return false;
+        return true;
     }
+    return position() == other2.position();
+}
 
-    return *m_block_iter == *other2.m_block_iter;
+std::pair<size_t, size_t> SstIterator::position() const
+{
+    if (!m_block_iter)
+    {
+        return {m_block_idx, 0};
+    }
+    if (m_block_iter->is_end())
+    {
+        return {m_block_idx + 1, 0};
+    }
+    return {m_block_idx, m_block_iter->get_index()};
 }
 
 bool SstIterator::operator!=(const BaseIterator &other) const
@@ -215,12 +253,12 @@ IteratorType SstIterator::get_type() const
 
 bool SstIterator::is_end() const
 {
-    return m_block_iter || m_block_idx >= m_sst->num_blocks();
+    return !m_sst || !m_block_iter || m_block_idx >= m_sst->num_blocks();
 }
 
 bool SstIterator::is_valid() const
 {
-    return m_block_iter && !m_block_iter->is_end() && m_block_idx < m_sst->num_blocks();
+    return m_sst && m_block_iter && !m_block_iter->is_end() && m_block_idx < m_sst->num_blocks();
 }
 
 std::pair<HeapIterator, HeapIterator>
@@ -230,14 +268,15 @@ SstIterator::merge_sst_iterator(std::vector<SstIterator> iter_vec,
     return std::make_pair(HeapIterator(), HeapIterator());
   }
 
-  HeapIterator it_begin;
+  // 用于 compaction，删除标记需要保留下来遮蔽更低层的旧版本
+  std::vector<SearchItem> items;
   for (auto &it : iter_vec) {
     while (it.is_valid() && !it.is_end()) {
-      it_begin.items.emplace(it->first, it->second, -it.get_sst_id(), 0,
-                             it.get_tranc_id());
+      items.emplace_back(it->first, it->second, -it.get_sst_id(), 0,
+                         it.get_tranc_id());
       ++it;
     }
   }
 
-  return std::make_pair(it_begin, HeapIterator());
+  return std::make_pair(HeapIterator(std::move(items), tranc_id, false), HeapIterator());
 }
\ No newline at end of file
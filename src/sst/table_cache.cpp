@@ -0,0 +1,115 @@
+#include "../../include/sst/table_cache.h"
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+TableCache::TableCache(std::string data_dir, size_t capacity, std::shared_ptr<BlockCache> block_cache)
+    : data_dir(std::move(data_dir)), capacity_(std::max<size_t>(capacity, 1)), block_cache(std::move(block_cache))
+{
+}
+
+std::string TableCache::get_sst_path(size_t sst_id) const
+{
+    std::stringstream ss;
+    ss << data_dir << "/sst_" << std::setfill('0') << std::setw(4) << sst_id;
+    return ss.str();
+}
+
+std::shared_ptr<SST> TableCache::get(size_t sst_id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_map_.find(sst_id);
+        if (it != cache_map_.end())
+        {
+            // 移到链表头部
+            cache_list.splice(cache_list.begin(), cache_list, it->second);
+            return *it->second;
+        }
+    }
+
+    // 打开文件时不持有锁，其他 SST 的访问不需要等待这次 IO
+    auto sst = SST::open(sst_id, FileObj::open(get_sst_path(sst_id), false), block_cache);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_count_++;
+    auto it = cache_map_.find(sst_id);
+    if (it != cache_map_.end())
+    {
+        // 其他线程已经打开了同一个 SST，使用缓存中的对象
+        cache_list.splice(cache_list.begin(), cache_list, it->second);
+        return *it->second;
+    }
+    insert(sst);
+    return sst;
+}
+
+void TableCache::put(std::shared_ptr<SST> sst)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_map_.find(sst->get_sst_id());
+    if (it != cache_map_.end())
+    {
+        cache_list.erase(it->second);
+        cache_map_.erase(it);
+    }
+    insert(std::move(sst));
+}
+
+void TableCache::insert(std::shared_ptr<SST> sst)
+{
+    if (cache_map_.size() >= capacity_)
+    {
+        // 移除最久没有使用的 SST
+        cache_map_.erase(cache_list.back()->get_sst_id());
+        cache_list.pop_back();
+    }
+    size_t sst_id = sst->get_sst_id();
+    cache_list.push_front(std::move(sst));
+    cache_map_[sst_id] = cache_list.begin();
+}
+
+void TableCache::remove(size_t sst_id)
+{
+    std::shared_ptr<SST> sst;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_map_.find(sst_id);
+        if (it != cache_map_.end())
+        {
+            sst = *it->second;
+            cache_list.erase(it->second);
+            cache_map_.erase(it);
+        }
+    }
+
+    if (sst != nullptr)
+    {
+        sst->del_sst();
+    }
+    else
+    {
+        // 没有打开的 SST 直接删除文件，不需要先读取元数据
+        std::filesystem::remove(get_sst_path(sst_id));
+    }
+}
+
+void TableCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_map_.clear();
+    cache_list.clear();
+}
+
+size_t TableCache::size()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_map_.size();
+}
+
+size_t TableCache::open_count()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_count_;
+}
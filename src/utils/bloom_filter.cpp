@@ -23,24 +23,28 @@ BloomFilter::BloomFilter(size_t expected_elements, double false_positive_rate)
 }
 
 // 添加元素到布隆过滤器
-void BloomFilter::add(const std::string &key)
+void BloomFilter::add(std::string_view key)
 {
     // 计算哈希值对应的位索引
-    // 双重哈希法，通过组合两个基础哈希生成多个哈希值
+    // 双重哈希法，通过组合两个基础哈希生成多个哈希值，基础哈希只需计算一次
+    size_t h1 = hash1(key);
+    size_t h2 = hash2(key);
     for (size_t i = 0; i < num_hashes_; i++)
     {
-        bits_[hash(key, i)] = true; // 标记对应位为true
+        bits_[hash(h1, h2, i)] = true; // 标记对应位为true
     }
 }
 
 // 判断bloom_filter中是否有这个元素
-bool BloomFilter::possibly_contains(const std::string &key) const
+bool BloomFilter::possibly_contains(std::string_view key) const
 {
     // 计算哈希值对应的位索引
     // 双重哈希法，通过组合两个基础哈希生成多个哈希值
+    size_t h1 = hash1(key);
+    size_t h2 = hash2(key);
     for (size_t i = 0; i < num_hashes_; i++)
     {
-        if (!bits_[hash(key, i)])
+        if (!bits_[hash(h1, h2, i)])
         {
             return false; // 如果有一个位为false，则认为元素不存在
         }
@@ -49,25 +53,27 @@ bool BloomFilter::possibly_contains(const std::string &key) const
 }
 
 // 基础哈希函数1（使用标准哈希）
-size_t BloomFilter::hash1(const std::string &key) const
+size_t BloomFilter::hash1(std::string_view key) const
 {
-    std::hash<std::string> hasher; // 标准字符串哈希器
-    return hasher(key);            // 返回哈希值
+    std::hash<std::string_view> hasher; // 标准字符串哈希器，与 std::hash<std::string> 结果一致
+    return hasher(key);                 // 返回哈希值
 }
 
 // 基础哈希函数2（添加"salt"扰动）
-size_t BloomFilter::hash2(const std::string &key) const
+size_t BloomFilter::hash2(std::string_view key) const
 {
-    std::hash<std::string> hasher;
-    return hasher(key + "salt"); // 通过添加后缀生成不同哈希值
+    // 复用线程内的缓冲区拼接后缀，避免每次都申请内存
+    // 哈希结果与 hasher(key + "salt") 相同，已经持久化的过滤器仍然有效
+    thread_local std::string salted;
+    salted.assign(key.data(), key.size());
+    salted.append("salt");
+    std::hash<std::string_view> hasher;
+    return hasher(salted); // 通过添加后缀生成不同哈希值
 }
 
 // 复合哈希函数（生成第idx个哈希值）
-size_t BloomFilter::hash(const std::string &key, size_t idx) const
+size_t BloomFilter::hash(size_t h1, size_t h2, size_t idx) const
 {
-    auto h1 = hash1(key);
-    auto h2 = hash2(key);
-
     // 线性组合公式：(h1 + i*h2) mod num_bits_
     return (h1 + idx * h2) % num_bits_;
 }
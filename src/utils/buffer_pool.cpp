@@ -0,0 +1,199 @@
+#include "../../include/utils/buffer_pool.h"
+#include <new>
+
+BufferPool::BufferPool(size_t capacity) : capacity(capacity)
+{
+}
+
+BufferPool::~BufferPool()
+{
+    clear();
+}
+
+BufferPool &BufferPool::global()
+{
+    // 不析构：静态对象析构顺序不确定，退出时可能还有 block 在归还缓冲区
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+}
+
+int BufferPool::class_of_size(size_t size)
+{
+    if (size < (size_t(1) << MIN_SHIFT) || size > (size_t(1) << MAX_SHIFT))
+    {
+        return -1;
+    }
+    // 向上取整到 2 的幂次
+    size_t shift = 64 - __builtin_clzll(size - 1);
+    return shift - MIN_SHIFT;
+}
+
+int BufferPool::class_of_capacity(size_t capacity)
+{
+    if (capacity < (size_t(1) << MIN_SHIFT))
+    {
+        return -1;
+    }
+    // 向下取整到 2 的幂次
+    size_t shift = 63 - __builtin_clzll(capacity);
+    if (shift > MAX_SHIFT)
+    {
+        return -1;
+    }
+    return shift - MIN_SHIFT;
+}
+
+std::vector<uint8_t> BufferPool::acquire(size_t size)
+{
+    acquires.fetch_add(1, std::memory_order_relaxed);
+    int cls = class_of_size(size);
+    if (cls >= 0)
+    {
+        auto &size_class = classes[cls];
+        std::unique_lock<std::mutex> lock(size_class.mtx);
+        if (!size_class.buffers.empty())
+        {
+            auto buf = std::move(size_class.buffers.back());
+            size_class.buffers.pop_back();
+            lock.unlock();
+            pooled_bytes.fetch_sub(buf.capacity(), std::memory_order_relaxed);
+            reuses.fetch_add(1, std::memory_order_relaxed);
+            buf.resize(size);
+            return buf;
+        }
+    }
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    std::vector<uint8_t> buf;
+    if (cls >= 0)
+    {
+        // 按级别的大小分配，归还后可以被这个级别的任何请求复用
+        buf.reserve(size_t(1) << (cls + MIN_SHIFT));
+    }
+    buf.resize(size);
+    return buf;
+}
+
+void BufferPool::release(std::vector<uint8_t> &&buf)
+{
+    std::vector<uint8_t> owned = std::move(buf);
+    size_t cap = owned.capacity();
+    int cls = class_of_capacity(cap);
+    if (cls >= 0)
+    {
+        auto &size_class = classes[cls];
+        std::lock_guard<std::mutex> lock(size_class.mtx);
+        // 检查上限和放入空闲列表在同一把锁内完成；不同级别的归还可能并发，
+        // 用 CAS 预留容量，避免都通过检查后超过上限
+        size_t pooled = pooled_bytes.load(std::memory_order_relaxed);
+        while (pooled + cap <= capacity.load(std::memory_order_relaxed))
+        {
+            if (pooled_bytes.compare_exchange_weak(pooled, pooled + cap, std::memory_order_relaxed))
+            {
+                releases.fetch_add(1, std::memory_order_relaxed);
+                size_class.buffers.push_back(std::move(owned));
+                return;
+            }
+        }
+    }
+
+    if (cap > 0)
+    {
+        discards.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void *BufferPool::allocate_object(size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(object_mtx);
+        auto &objects = free_objects[size];
+        if (!objects.empty())
+        {
+            void *p = objects.back();
+            objects.pop_back();
+            object_reuses.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+    }
+    object_allocations.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+}
+
+void BufferPool::deallocate_object(void *p, size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(object_mtx);
+        auto &objects = free_objects[size];
+        if (capacity.load(std::memory_order_relaxed) > 0 && objects.size() < LSM_BUFFER_POOL_MAX_OBJECTS)
+        {
+            objects.push_back(p);
+            return;
+        }
+    }
+    ::operator delete(p);
+}
+
+void BufferPool::set_capacity(size_t new_capacity)
+{
+    capacity.store(new_capacity, std::memory_order_relaxed);
+    // 从大到小释放，直到不超过新的上限
+    for (int cls = NUM_CLASSES - 1; cls >= 0 && pooled_bytes.load(std::memory_order_relaxed) > new_capacity; cls--)
+    {
+        auto &size_class = classes[cls];
+        std::lock_guard<std::mutex> lock(size_class.mtx);
+        while (!size_class.buffers.empty() && pooled_bytes.load(std::memory_order_relaxed) > new_capacity)
+        {
+            pooled_bytes.fetch_sub(size_class.buffers.back().capacity(), std::memory_order_relaxed);
+            size_class.buffers.pop_back();
+        }
+    }
+}
+
+void BufferPool::clear()
+{
+    for (auto &size_class : classes)
+    {
+        std::lock_guard<std::mutex> lock(size_class.mtx);
+        for (auto &buf : size_class.buffers)
+        {
+            pooled_bytes.fetch_sub(buf.capacity(), std::memory_order_relaxed);
+        }
+        size_class.buffers.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(object_mtx);
+    for (auto &[size, objects] : free_objects)
+    {
+        for (void *p : objects)
+        {
+            ::operator delete(p);
+        }
+    }
+    free_objects.clear();
+}
+
+BufferPoolStats BufferPool::stats() const
+{
+    BufferPoolStats res;
+    res.acquires = acquires.load(std::memory_order_relaxed);
+    res.reuses = reuses.load(std::memory_order_relaxed);
+    res.allocations = allocations.load(std::memory_order_relaxed);
+    res.releases = releases.load(std::memory_order_relaxed);
+    res.discards = discards.load(std::memory_order_relaxed);
+    res.object_allocations = object_allocations.load(std::memory_order_relaxed);
+    res.object_reuses = object_reuses.load(std::memory_order_relaxed);
+    res.pooled_bytes = pooled_bytes.load(std::memory_order_relaxed);
+    return res;
+}
+
+void BufferPool::reset_stats()
+{
+    acquires.store(0, std::memory_order_relaxed);
+    reuses.store(0, std::memory_order_relaxed);
+    allocations.store(0, std::memory_order_relaxed);
+    releases.store(0, std::memory_order_relaxed);
+    discards.store(0, std::memory_order_relaxed);
+    object_allocations.store(0, std::memory_order_relaxed);
+    object_reuses.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,214 @@
+#include "../../include/utils/compression.h"
+#include "../../include/utils/buffer_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr size_t LZ_MIN_MATCH = 4;
+static constexpr size_t LZ_MAX_OFFSET = 65535;
+static constexpr size_t LZ_HASH_BITS = 12;
+
+static uint32_t load_u32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(uint32_t));
+    return v;
+}
+
+// 长度超过 token 能表示的 15 时，剩余部分写成若干个 255 加一个小于 255 的字节
+static void write_length(std::vector<uint8_t> &out, size_t len)
+{
+    while (len >= 255)
+    {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(len));
+}
+
+static size_t read_length(const uint8_t *&ip, const uint8_t *end)
+{
+    size_t len = 0;
+    uint8_t b;
+    do
+    {
+        if (ip >= end)
+        {
+            throw std::runtime_error("Corrupted compressed data");
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+// 写出一个 sequence，match_len 为 0 表示最后一个只有字面量的 sequence
+static void write_sequence(std::vector<uint8_t> &out, const uint8_t *literal, size_t literal_len, size_t offset, size_t match_len)
+{
+    size_t match_code = match_len == 0 ? 0 : match_len - LZ_MIN_MATCH;
+    uint8_t token = static_cast<uint8_t>((std::min<size_t>(literal_len, 15) << 4) | std::min<size_t>(match_code, 15));
+    out.push_back(token);
+    if (literal_len >= 15)
+    {
+        write_length(out, literal_len - 15);
+    }
+    out.insert(out.end(), literal, literal + literal_len);
+
+    if (match_len == 0)
+    {
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (match_code >= 15)
+    {
+        write_length(out, match_code - 15);
+    }
+}
+
+CompressionType Compression::compress(CompressionType type, const uint8_t *src, size_t len, std::vector<uint8_t> &out)
+{
+    switch (type)
+    {
+    case CompressionType::LZ:
+        return lz_compress(src, len, out) ? CompressionType::LZ : CompressionType::None;
+    default:
+        return CompressionType::None;
+    }
+}
+
+std::vector<uint8_t> Compression::decompress(CompressionType type, const uint8_t *src, size_t len)
+{
+    switch (type)
+    {
+    case CompressionType::None:
+        return std::vector<uint8_t>(src, src + len);
+    case CompressionType::LZ:
+        return lz_decompress(src, len);
+    default:
+        throw std::runtime_error("Unknown compression type");
+    }
+}
+
+bool Compression::lz_compress(const uint8_t *src, size_t len, std::vector<uint8_t> &out)
+{
+    if (len > UINT32_MAX)
+    {
+        return false;
+    }
+    size_t start = out.size();
+    uint32_t raw_len = len;
+    out.resize(start + sizeof(uint32_t));
+    memcpy(out.data() + start, &raw_len, sizeof(uint32_t));
+
+    // 哈希表记录每个 4 字节序列最近一次出现的位置 + 1，0 表示没有出现过
+    std::vector<uint32_t> table(1 << LZ_HASH_BITS, 0);
+    size_t anchor = 0; // 还没有写出的字面量的起点
+    size_t i = 0;
+    while (i + LZ_MIN_MATCH <= len)
+    {
+        uint32_t seq = load_u32(src + i);
+        uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        size_t candidate = table[h];
+        table[h] = i + 1;
+
+        if (candidate == 0 || i - (candidate - 1) > LZ_MAX_OFFSET || load_u32(src + candidate - 1) != seq)
+        {
+            i++;
+            continue;
+        }
+        candidate--;
+
+        size_t match_len = LZ_MIN_MATCH;
+        while (i + match_len < len && src[candidate + match_len] == src[i + match_len])
+        {
+            match_len++;
+        }
+        write_sequence(out, src + anchor, i - anchor, i - candidate, match_len);
+        i += match_len;
+        anchor = i;
+
+        // 压缩后的数据已经不比原数据小，没有必要继续
+        if (out.size() - start >= len)
+        {
+            out.resize(start);
+            return false;
+        }
+    }
+    write_sequence(out, src + anchor, len - anchor, 0, 0);
+
+    if (out.size() - start >= len)
+    {
+        out.resize(start);
+        return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> Compression::lz_decompress(const uint8_t *src, size_t len)
+{
+    if (len < sizeof(uint32_t))
+    {
+        throw std::runtime_error("Corrupted compressed data");
+    }
+    uint32_t raw_len;
+    memcpy(&raw_len, src, sizeof(uint32_t));
+
+    // 解压后的 block 由调用方接管，缓存淘汰后归还到池中
+    std::vector<uint8_t> out = BufferPool::global().acquire(raw_len);
+    uint8_t *op = out.data();
+    uint8_t *op_end = out.data() + raw_len;
+    const uint8_t *ip = src + sizeof(uint32_t);
+    const uint8_t *end = src + len;
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+
+        // 字面量
+        size_t literal_len = token >> 4;
+        if (literal_len == 15)
+        {
+            literal_len += read_length(ip, end);
+        }
+        if (literal_len > static_cast<size_t>(end - ip) || literal_len > static_cast<size_t>(op_end - op))
+        {
+            throw std::runtime_error("Corrupted compressed data");
+        }
+        memcpy(op, ip, literal_len);
+        op += literal_len;
+        ip += literal_len;
+        if (ip == end)
+        {
+            break;
+        }
+
+        // 匹配部分，源和目标可能重叠，只能逐字节复制
+        if (end - ip < 2)
+        {
+            throw std::runtime_error("Corrupted compressed data");
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t match_len = (token & 0x0f) + LZ_MIN_MATCH;
+        if ((token & 0x0f) == 15)
+        {
+            match_len += read_length(ip, end);
+        }
+        if (offset == 0 || offset > static_cast<size_t>(op - out.data()) || match_len > static_cast<size_t>(op_end - op))
+        {
+            throw std::runtime_error("Corrupted compressed data");
+        }
+        const uint8_t *match = op - offset;
+        for (size_t k = 0; k < match_len; k++)
+        {
+            op[k] = match[k];
+        }
+        op += match_len;
+    }
+
+    if (op != op_end)
+    {
+        throw std::runtime_error("Corrupted compressed data");
+    }
+    return out;
+}
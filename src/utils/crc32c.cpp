@@ -0,0 +1,88 @@
+#include "../../include/utils/crc32c.h"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define LSM_CRC32C_X86
+#endif
+
+// 反转后的 Castagnoli 多项式
+static constexpr uint32_t CRC32C_POLY = 0x82f63b78;
+
+static constexpr std::array<uint32_t, 256> make_table()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> CRC32C_TABLE = make_table();
+
+static uint32_t crc32c_portable(const uint8_t *p, size_t len, uint32_t crc)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = CRC32C_TABLE[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef LSM_CRC32C_X86
+__attribute__((target("sse4.2"))) static uint32_t crc32c_sse42(const uint8_t *p, size_t len, uint32_t crc)
+{
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (len >= sizeof(uint64_t))
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(uint64_t));
+        crc64 = _mm_crc32_u64(crc64, v);
+        p += sizeof(uint64_t);
+        len -= sizeof(uint64_t);
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (len >= sizeof(uint32_t))
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(uint32_t));
+        crc = _mm_crc32_u32(crc, v);
+        p += sizeof(uint32_t);
+        len -= sizeof(uint32_t);
+    }
+    while (len > 0)
+    {
+        crc = _mm_crc32_u8(crc, *p++);
+        len--;
+    }
+    return crc;
+}
+
+static bool has_sse42()
+{
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+}
+#endif
+
+uint32_t crc32c(const void *data, size_t len, uint32_t crc)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+#ifdef LSM_CRC32C_X86
+    if (has_sse42())
+    {
+        return ~crc32c_sse42(p, len, crc);
+    }
+#endif
+    return ~crc32c_portable(p, len, crc);
+}
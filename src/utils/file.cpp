@@ -1,5 +1,6 @@
 #include "../../include/utils/file.h"
 #include "../../include/utils/mmap_file.h"
+#include "../../include/utils/buffer_pool.h"
 #include <algorithm>
 #include <cstdint>
 #include <memory>
@@ -57,7 +58,8 @@ std::vector<uint8_t> FileObj::read_to_slice(size_t offset, size_t length) {
     throw std::runtime_error("Read out of range");
   }
 
-  auto result = m_file->read(offset, length);
+  auto result = BufferPool::global().acquire(length);
+  m_file->read(offset, result.data(), length);
 
   return result;
 }
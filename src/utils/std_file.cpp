@@ -44,11 +44,15 @@ bool StdFile::write(size_t offset, const void *data, size_t length) {
 
 std::vector<uint8_t> StdFile::read(size_t offset, size_t length) {
   std::vector<uint8_t> buf(length);
+  read(offset, buf.data(), length);
+  return buf;
+}
+
+void StdFile::read(size_t offset, void *data, size_t length) {
   file_.seekg(offset, std::ios::beg);
-  if (!file_.read(reinterpret_cast<char *>(buf.data()), length)) {
+  if (!file_.read(static_cast<char *>(data), length)) {
     throw std::runtime_error("Failed to read file");
   }
-  return buf;
 }
 
 bool StdFile::sync() {
@@ -20,6 +20,7 @@ Record Record::putRecord(uint64_t tranc_id, const std::string &key,
   record.record_len_ = sizeof(record_len_) + sizeof(tranc_id_) +
                        sizeof(Record) + sizeof(uint16_t) + key.size() +
                        sizeof(uint16_t) + value.size();
+  return record;
 }
 
 Record Record::deleteRecord(uint64_t tranc_id, const std::string &key) {
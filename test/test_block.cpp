@@ -1,9 +1,15 @@
 #include "../include/block/block.h"
 #include "../include/block/block_iterator.h"
+#include "../include/block/blockmeta.h"
 #include "../include/const.h"
+#include "../include/block/key_prefix_index.h"
+#include "../include/utils/crc32c.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iomanip>
 #include <memory>
+#include <random>
+#include <set>
 #include <vector>
 
 class BlockTest : public ::testing::Test
@@ -17,34 +23,39 @@ protected:
         Entry1: key="apple", value="red"
         Entry2: key="banana", value="yellow"
         Entry3: key="orange", value="orange"
+        三个 key 没有公共前缀，shared_len 都为 0，只有第一条记录是重启点
         */
         std::vector<uint8_t> encoded = {
-            // Data Section
+            // Data Section，长度和事务 id 都是 varint
             // Entry 1: "apple" -> "red"
-            5, 0,                    // key_len = 5
+            0,                       // shared_len = 0
+            5,                       // unshared_len = 5
+            3,                       // value_len = 3
             'a', 'p', 'p', 'l', 'e', // key
-            3, 0,                    // value_len = 3
             'r', 'e', 'd',           // value
+            0,                       // tranc_id = 0
 
             // Entry 2: "banana" -> "yellow"
-            6, 0,                         // key_len = 6
+            0,                            // shared_len = 0
+            6,                            // unshared_len = 6
+            6,                            // value_len = 6
             'b', 'a', 'n', 'a', 'n', 'a', // key
-            6, 0,                         // value_len = 6
             'y', 'e', 'l', 'l', 'o', 'w', // value
+            0,                            // tranc_id = 0
 
             // Entry 3: "orange" -> "orange"
-            6, 0,                         // key_len = 6
+            0,                            // shared_len = 0
+            6,                            // unshared_len = 6
+            6,                            // value_len = 6
             'o', 'r', 'a', 'n', 'g', 'e', // key
-            6, 0,                         // value_len = 6
             'o', 'r', 'a', 'n', 'g', 'e', // value
+            0,                            // tranc_id = 0
 
-            // Offset Section (每个entry的起始位置)
-            0, 0,  // offset[0] = 0
-            12, 0, // offset[1] = 12 (第二个entry的起始位置)
-            28, 0, // offset[2] = 24 (第三个entry的起始位置)
+            // Restart Section (每个重启点的起始位置)
+            0, 0, 0, 0, // restart[0] = 0
 
-            // Num of elements
-            3, 0 // num_elements = 3
+            1, 0, 0, 0, // num_restarts = 1
+            3, 0, 0, 0  // num_elements = 3
         };
         return encoded;
     }
@@ -80,6 +91,11 @@ TEST_F(BlockTest, EncodeTest)
     EXPECT_EQ(decoded->get_value_binary("apple", 0).value(), "red");
     EXPECT_EQ(decoded->get_value_binary("banana", 0).value(), "yellow");
     EXPECT_EQ(decoded->get_value_binary("orange", 0).value(), "orange");
+
+    // 解码后的 block 直接使用编码数据，再次编码结果不变
+    EXPECT_EQ(decoded->encode(), encoded);
+    EXPECT_EQ(decoded->cur_size(), encoded.size());
+    EXPECT_THROW(decoded->add_entry("pear", "green", 0, true), std::runtime_error);
 }
 
 // 测试二分查找
@@ -157,6 +173,222 @@ TEST_F(BlockTest, LargeDataTest)
     }
 }
 
+// 测试前缀压缩和跨越重启点的多版本查找
+TEST_F(BlockTest, PrefixCompressionTest)
+{
+    auto block = std::make_shared<Block>(LSM_BLOCK_MEM_LIMIT);
+    std::string prefix = REDIS_SORTED_SET_PREFIX;
+    size_t raw_bytes = 0; // 不做前缀压缩时记录的总大小
+    const int n = 100;
+    for (int i = 0; i < n; i++)
+    {
+        char key_buf[64];
+        snprintf(key_buf, sizeof(key_buf), "%skey%03d", prefix.c_str(), i);
+        // 每个 key 有 3 个版本，事务 id 从大到小排列
+        for (int tranc_id = 3; tranc_id >= 1; tranc_id--)
+        {
+            ASSERT_TRUE(block->add_entry(key_buf, "value" + std::to_string(tranc_id), tranc_id, false));
+            raw_bytes += 3 * sizeof(uint16_t) + strlen(key_buf) + strlen("value1") + sizeof(uint64_t);
+        }
+    }
+    // 大部分记录只保存 key 的最后几个字节
+    EXPECT_LT(block->cur_size(), raw_bytes / 2);
+
+    auto decoded = Block::decode(block->encode());
+    EXPECT_EQ(decoded->size(), n * 3);
+    EXPECT_EQ(decoded->get_first_key(), prefix + "key000");
+    for (int i = 0; i < n; i++)
+    {
+        char key_buf[64];
+        snprintf(key_buf, sizeof(key_buf), "%skey%03d", prefix.c_str(), i);
+        EXPECT_EQ(decoded->get_value_binary(key_buf, 0).value(), "value3");
+        EXPECT_EQ(decoded->get_value_binary(key_buf, 2).value(), "value2");
+        EXPECT_EQ(decoded->get_value_binary(key_buf, 1).value(), "value1");
+    }
+    EXPECT_FALSE(decoded->get_value_binary(prefix + "key", 0).has_value());
+    EXPECT_FALSE(decoded->get_value_binary(prefix + "key100", 0).has_value());
+
+    // 顺序遍历还原出完整的 key
+    int count = 0;
+    for (auto it = decoded->begin(); it != decoded->end(); ++it)
+    {
+        char key_buf[64];
+        snprintf(key_buf, sizeof(key_buf), "%skey%03d", prefix.c_str(), count / 3);
+        EXPECT_EQ(it->first, key_buf);
+        EXPECT_EQ(it.get_tranc_id(), 3 - count % 3);
+        count++;
+    }
+    EXPECT_EQ(count, n * 3);
+
+    auto result = decoded->get_monotony_predicate(0, [&](const std::string &key)
+                                                  {
+        if (key < prefix + "key010") {
+            return 1;
+        }
+        if (key > prefix + "key019") {
+            return -1;
+        }
+        return 0; });
+    ASSERT_TRUE(result.has_value());
+    auto [it_begin, it_end] = result.value();
+    EXPECT_EQ((*it_begin)->first, prefix + "key010");
+    EXPECT_EQ((*it_end)->first, prefix + "key020");
+}
+
+// 测试不还原 key 的查找：key 之间有长短不一的公共前缀
+TEST_F(BlockTest, ViewLookupTest)
+{
+    std::set<std::string> keys;
+    std::mt19937 rng(42);
+    while (keys.size() < 300)
+    {
+        // 只用 a/b 两个字符，生成大量互为前缀的 key
+        std::string key;
+        size_t len = 1 + rng() % 8;
+        for (size_t i = 0; i < len; i++)
+        {
+            key.push_back('a' + rng() % 2);
+        }
+        keys.insert(key);
+    }
+
+    auto block = std::make_shared<Block>(LSM_BLOCK_MEM_LIMIT);
+    for (auto &key : keys)
+    {
+        ASSERT_TRUE(block->add_entry(key, "v_" + key, 1, false));
+    }
+    auto decoded = Block::decode(block->encode());
+
+    for (auto &key : keys)
+    {
+        auto value = decoded->get_value_view(key, 0);
+        ASSERT_TRUE(value.has_value()) << key;
+        EXPECT_EQ(*value, "v_" + key);
+        EXPECT_EQ(BlockIterator(decoded, key, 0).key(), key);
+
+        // 不存在的 key：追加字符或去掉最后一个字符
+        for (auto missing : {key + "c", key + "a", key.substr(0, key.size() - 1)})
+        {
+            EXPECT_EQ(decoded->get_value_view(missing, 0).has_value(), keys.count(missing) > 0) << missing;
+        }
+    }
+}
+
+// 测试点查用的哈希索引
+TEST_F(BlockTest, HashIndexTest)
+{
+    auto plain = std::make_shared<Block>(LSM_BLOCK_MEM_LIMIT);
+    auto indexed = std::make_shared<Block>(LSM_BLOCK_MEM_LIMIT, true);
+    const int n = 200;
+    for (int i = 0; i < n; i++)
+    {
+        std::string key = "key" + std::to_string(1000 + i * 2);
+        // 每隔几个 key 写入多个版本，使同一个 key 跨越重启点
+        int versions = i % 7 == 0 ? 20 : 1;
+        for (int tranc_id = versions; tranc_id >= 1; tranc_id--)
+        {
+            std::string value = "value" + std::to_string(i) + "_" + std::to_string(tranc_id);
+            ASSERT_TRUE(plain->add_entry(key, value, tranc_id, false));
+            ASSERT_TRUE(indexed->add_entry(key, value, tranc_id, false));
+        }
+    }
+    EXPECT_GT(indexed->cur_size(), plain->cur_size());
+
+    auto encoded = indexed->encode();
+    EXPECT_EQ(encoded.size(), indexed->cur_size());
+    auto decoded = Block::decode(encoded);
+    EXPECT_EQ(decoded->encode(), encoded);
+
+    for (int i = 0; i < n; i++)
+    {
+        std::string key = "key" + std::to_string(1000 + i * 2);
+        int versions = i % 7 == 0 ? 20 : 1;
+        EXPECT_EQ(decoded->get_value_view(key, 0).value(), "value" + std::to_string(i) + "_" + std::to_string(versions));
+        EXPECT_EQ(decoded->get_value_view(key, 1).value(), "value" + std::to_string(i) + "_1");
+        EXPECT_EQ(BlockIterator(decoded, key, 1).value(), "value" + std::to_string(i) + "_1");
+
+        // 不存在的 key
+        std::string missing = "key" + std::to_string(1000 + i * 2 + 1);
+        EXPECT_FALSE(decoded->get_value_view(missing, 0).has_value());
+        EXPECT_TRUE(BlockIterator(decoded, missing, 0).is_end());
+    }
+
+    // 顺序遍历不受哈希索引影响
+    size_t count = 0;
+    for (auto it = decoded->begin(); it.is_valid(); ++it)
+    {
+        count++;
+    }
+    EXPECT_EQ(count, decoded->size());
+}
+
+// 测试变长编码：小记录开销小，大 key 和大 value 不会被截断
+TEST_F(BlockTest, VarintEntryTest)
+{
+    Block small(1024);
+    size_t empty_size = small.cur_size();
+    small.add_entry("k1", "v", 5, false);
+    // 3 个长度各 1 字节 + key + value + 事务 id 1 字节，再加一个重启点
+    EXPECT_EQ(small.cur_size() - empty_size, 3 + 2 + 1 + 1 + sizeof(uint32_t));
+
+    auto block = std::make_shared<Block>(1024);
+    std::string big_key(70000, 'k');
+    std::string big_value(100000, 'v');
+    block->add_entry("a", "small", 1, false);
+    block->add_entry(big_key, big_value, UINT64_MAX, true);
+    block->add_entry(big_key + "z", "after", 300, true);
+
+    auto decoded = Block::decode(block->encode());
+    EXPECT_EQ(decoded->get_value_binary("a").value(), "small");
+    EXPECT_EQ(decoded->get_value_binary(big_key).value(), big_value);
+    EXPECT_EQ(decoded->get_value_binary(big_key + "z").value(), "after");
+    auto it = BlockIterator(decoded, big_key, 0);
+    EXPECT_EQ(it.get_tranc_id(), UINT64_MAX);
+    ++it;
+    EXPECT_EQ(it.key(), big_key + "z");
+    EXPECT_EQ(it.get_tranc_id(), 300);
+}
+
+// 测试 key 前缀索引与 std::lower_bound 结果一致
+TEST_F(BlockTest, KeyPrefixIndexTest)
+{
+    std::mt19937 rng(7);
+    std::set<std::string> key_set;
+    while (key_set.size() < 1000)
+    {
+        // 带长公共前缀，之后的部分长短不一，有大量前 8 个字节相同的 key
+        std::string key = REDIS_HASH_HEADER;
+        size_t len = rng() % 12;
+        for (size_t i = 0; i < len; i++)
+        {
+            key.push_back("ab\0z"[rng() % 4]);
+        }
+        key_set.insert(key);
+    }
+    std::vector<std::string> keys(key_set.begin(), key_set.end());
+    std::vector<std::string_view> views(keys.begin(), keys.end());
+    KeyPrefixIndex index;
+    index.build(views);
+
+    auto check = [&](const std::string &target)
+    {
+        size_t expected = std::lower_bound(keys.begin(), keys.end(), target) - keys.begin();
+        size_t actual = index.lower_bound(target, [&](size_t i) -> std::string_view
+                                          { return keys[i]; });
+        EXPECT_EQ(actual, expected) << target;
+    };
+    for (auto &key : keys)
+    {
+        check(key);
+        check(key + "a");
+        check(key.substr(0, key.size() - 1));
+    }
+    check("");
+    check("A");
+    check("Z");
+    check(std::string(REDIS_HASH_HEADER) + "zzzzzzzzzzzzz");
+}
+
 // 测试错误处理
 TEST_F(BlockTest, ErrorHandlingTest)
 {
@@ -167,6 +399,57 @@ TEST_F(BlockTest, ErrorHandlingTest)
     // 测试空vector
     std::vector<uint8_t> empty_data;
     EXPECT_THROW(Block::decode(empty_data), std::runtime_error);
+
+    // 测试CRC32C校验
+    Block block(1024);
+    block.add_entry("apple", "red", 1, false);
+    auto encoded = block.encode();
+    uint32_t crc = crc32c(encoded.data(), encoded.size());
+    encoded.resize(encoded.size() + sizeof(uint32_t));
+    memcpy(encoded.data() + encoded.size() - sizeof(uint32_t), &crc, sizeof(uint32_t));
+    EXPECT_EQ(Block::decode(encoded, true)->get_value_binary("apple").value(), "red");
+    encoded[3] ^= 0x01;
+    EXPECT_THROW(Block::decode(encoded, true), std::runtime_error);
+}
+
+// 测试索引使用的短分隔 key
+TEST_F(BlockTest, SeparatorTest)
+{
+    EXPECT_EQ(BlockMeta::shortest_separator("abcdef", "abzz"), "abd");
+    EXPECT_EQ(BlockMeta::shortest_separator("abc", "abcd"), "abc");      // a 是 b 的前缀
+    EXPECT_EQ(BlockMeta::shortest_separator("abc1xyz", "abc2"), "abc1y"); // 第一个不同的字节只差 1
+    EXPECT_EQ(BlockMeta::shortest_successor("abc"), "b");
+    EXPECT_EQ(BlockMeta::shortest_successor("\xff\xff"), "\xff\xff");
+
+    // 随机 key 上验证 a <= s < b
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> len_dist(1, 12);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    for (int i = 0; i < 10000; i++)
+    {
+        std::string a, b;
+        for (int j = len_dist(gen); j > 0; j--)
+        {
+            a.push_back(static_cast<char>(byte_dist(gen)));
+        }
+        for (int j = len_dist(gen); j > 0; j--)
+        {
+            b.push_back(static_cast<char>(byte_dist(gen)));
+        }
+        if (a == b)
+        {
+            continue;
+        }
+        if (b < a)
+        {
+            std::swap(a, b);
+        }
+        auto sep = BlockMeta::shortest_separator(a, b);
+        EXPECT_LE(a, sep);
+        EXPECT_LT(sep, b);
+        EXPECT_LE(sep.size(), a.size());
+        EXPECT_LE(a, BlockMeta::shortest_successor(a));
+    }
 }
 
 // 测试迭代器
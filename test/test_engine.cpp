@@ -1,8 +1,14 @@
 #include "../include/engine/engine.h"
 #include <filesystem>
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class EngineTest : public ::testing::Test
 {
@@ -66,6 +72,8 @@ TEST_F(EngineTest, PersistenceTest)
     }
 
     LSMEngine engine(test_dir);
+    // 启动时不打开 SST，第一次访问时才打开
+    EXPECT_EQ(engine.open_sst_count(), 0);
     for (int i = 0; i < num; i++)
     {
         std::string key = "key" + std::to_string(i);
@@ -78,6 +86,391 @@ TEST_F(EngineTest, PersistenceTest)
             ASSERT_FALSE(engine.get(key, 0).has_value());
         }
     }
+    EXPECT_GT(engine.open_sst_count(), 0);
+    EXPECT_LE(engine.open_sst_count(), LSM_TABLE_CACHE_CAPACITY);
+}
+
+static std::set<std::string> list_blob_files(const std::string &dir)
+{
+    std::set<std::string> blob_files;
+    for (auto &entry : std::filesystem::directory_iterator(dir))
+    {
+        std::string filename = entry.path().filename().string();
+        if (filename.rfind("blob_", 0) == 0)
+        {
+            blob_files.insert(filename);
+        }
+    }
+    return blob_files;
+}
+
+TEST_F(EngineTest, LargeValueTest)
+{
+    auto big_value = [](int i)
+    { return std::string(LSM_BLOB_VALUE_THRESHOLD + i, 'a' + i % 26); };
+    {
+        LSMEngine engine(test_dir);
+        for (int i = 0; i < 100; i++)
+        {
+            engine.put("key" + std::to_string(i), big_value(i), 0);
+        }
+        engine.remove("key0", 0);
+    }
+
+    // 大 value 写入了 blob 文件
+    EXPECT_GT(list_blob_files(test_dir).size(), 0);
+
+    LSMEngine engine(test_dir);
+    ASSERT_FALSE(engine.get("key0", 0).has_value());
+    for (int i = 1; i < 100; i++)
+    {
+        ASSERT_EQ(engine.get("key" + std::to_string(i), 0).value().first, big_value(i));
+    }
+}
+
+// 等待刷盘线程把冻结表全部写入 SST
+static void wait_flush(LSMEngine &engine)
+{
+    while (engine.frozen_memtable_count() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// 通过范围查询读出所有记录
+static std::map<std::string, std::string> scan_all(LSMEngine &engine)
+{
+    std::map<std::string, std::string> res;
+    auto result = engine.iter_monotony_predicate(0, [](const std::string &)
+                                                 { return 0; });
+    if (!result.has_value())
+    {
+        return res;
+    }
+    auto [it, end] = result.value();
+    for (; it != end && it.is_valid(); ++it)
+    {
+        auto [key, value] = *it;
+        EXPECT_TRUE(res.emplace(key, value).second) << "duplicate key " << key;
+    }
+    return res;
+}
+
+TEST_F(EngineTest, CompactionTest)
+{
+    std::map<std::string, std::string> kvs;
+    auto check = [&](LSMEngine &engine)
+    {
+        for (int i = 0; i < 5000; i++)
+        {
+            char key[32];
+            snprintf(key, sizeof(key), "key%05d", i);
+            auto res = engine.get(key, 0);
+            if (kvs.count(key))
+            {
+                ASSERT_TRUE(res.has_value()) << key;
+                ASSERT_EQ(res->first, kvs[key]);
+            }
+            else
+            {
+                ASSERT_FALSE(res.has_value()) << key;
+            }
+        }
+        EXPECT_EQ(scan_all(engine), kvs);
+    };
+
+    {
+        // 很小的活跃表，写入过程中 L0 超过 LSM_SST_LEVEL_RATIO 个 SST，触发 compaction
+        LSMEngine engine(test_dir, 1, MemTableRepType::SkipList, 4 * 1024);
+        for (int round = 0; round < 3; round++)
+        {
+            for (int i = 0; i < 5000; i++)
+            {
+                char key[32];
+                snprintf(key, sizeof(key), "key%05d", i);
+                if (round > 0 && i % 7 == round)
+                {
+                    engine.remove(key, 0);
+                    kvs.erase(key);
+                }
+                else if (round == 0 || i % 3 == round)
+                {
+                    std::string value = "value" + std::to_string(round) + "_" + std::to_string(i);
+                    engine.put(key, value, 0);
+                    kvs[key] = value;
+                }
+            }
+        }
+        wait_flush(engine);
+        EXPECT_GT(engine.level_sst_count(1), 0);
+        check(engine);
+    }
+
+    // 重启后所有 SST 按 id 从新到旧加载
+    LSMEngine engine(test_dir);
+    check(engine);
+}
+
+TEST_F(EngineTest, ReadDuringCompactionTest)
+{
+    // compaction 在刷盘线程中进行，读操作同时进行并且总能读到已经写入的数据
+    LSMEngine engine(test_dir, 1, MemTableRepType::SkipList, 4 * 1024);
+    constexpr int num_keys = 5000;
+    std::atomic<int> written{0};
+    std::atomic<int> bad_reads{0};
+
+    std::thread reader([&]
+                       {
+        while (written < num_keys)
+        {
+            int n = written;
+            for (int i = std::max(0, n - 200); i < n; i++)
+            {
+                auto res = engine.get("key" + std::to_string(i), 0);
+                if (!res.has_value() || res->first != "value" + std::to_string(i))
+                {
+                    bad_reads++;
+                }
+            }
+        } });
+
+    for (int i = 0; i < num_keys; i++)
+    {
+        engine.put("key" + std::to_string(i), "value" + std::to_string(i), 0);
+        written = i + 1;
+    }
+    reader.join();
+    wait_flush(engine);
+
+    EXPECT_GT(engine.level_sst_count(1), 0);
+    EXPECT_EQ(bad_reads, 0);
+}
+
+TEST_F(EngineTest, CompressedLevelTest)
+{
+    // L0 不压缩，compaction 写入 L1 的 SST 使用 LZ 压缩
+    auto value_of = [](int i)
+    { return std::string(200, 'a' + i % 26) + std::to_string(i); };
+    constexpr int num_keys = 5000;
+    size_t raw_bytes = 0;
+    {
+        LSMEngine engine(test_dir, 1, MemTableRepType::SkipList, 4 * 1024);
+        for (int i = 0; i < num_keys; i++)
+        {
+            std::string key = "key" + std::to_string(i);
+            raw_bytes += key.size() + value_of(i).size();
+            engine.put(key, value_of(i), 0);
+        }
+        wait_flush(engine);
+        ASSERT_GT(engine.level_sst_count(1), 0);
+
+        for (int i = 0; i < num_keys; i++)
+        {
+            auto res = engine.get("key" + std::to_string(i), 0);
+            ASSERT_TRUE(res.has_value());
+            ASSERT_EQ(res->first, value_of(i));
+        }
+    }
+
+    // 大部分数据在压缩过的 L1 中，所有 SST 的总大小远小于原始数据
+    size_t sst_bytes = 0;
+    for (auto &entry : std::filesystem::directory_iterator(test_dir))
+    {
+        if (entry.path().filename().string().rfind("sst_", 0) == 0)
+        {
+            sst_bytes += entry.file_size();
+        }
+    }
+    EXPECT_LT(sst_bytes, raw_bytes / 2);
+
+    // 重启后从文件读取压缩过的数据块
+    LSMEngine engine(test_dir);
+    std::map<std::string, std::string> kvs;
+    for (int i = 0; i < num_keys; i++)
+    {
+        kvs["key" + std::to_string(i)] = value_of(i);
+        auto res = engine.get("key" + std::to_string(i), 0);
+        ASSERT_TRUE(res.has_value());
+        ASSERT_EQ(res->first, value_of(i));
+    }
+    EXPECT_EQ(scan_all(engine), kvs);
+}
+
+TEST_F(EngineTest, BlobGarbageCollectionTest)
+{
+    auto big_value = [](int round, int i)
+    { return std::string(LSM_BLOB_VALUE_THRESHOLD + i, 'a' + round); };
+    constexpr int num_keys = 20;
+    std::map<std::string, std::string> kvs;
+
+    {
+        // 每次打开引擎都会新建一个 blob 文件，第一轮的 value 都在第一个文件中
+        LSMEngine engine(test_dir, 1, MemTableRepType::SkipList, 4 * 1024);
+        for (int i = 0; i < num_keys; i++)
+        {
+            kvs["key" + std::to_string(i)] = big_value(0, i);
+            engine.put("key" + std::to_string(i), big_value(0, i), 0);
+        }
+    }
+    auto old_blob_files = list_blob_files(test_dir);
+    ASSERT_EQ(old_blob_files.size(), 1);
+
+    {
+        // 覆盖或删除第一轮的所有 value，活跃表很小，每次写入都会刷盘并多次触发 compaction
+        LSMEngine engine(test_dir, 1, MemTableRepType::SkipList, 4 * 1024);
+        for (int i = 0; i < num_keys; i++)
+        {
+            std::string key = "key" + std::to_string(i);
+            if (i % 4 == 0)
+            {
+                kvs.erase(key);
+                engine.remove(key, 0);
+            }
+            else
+            {
+                kvs[key] = big_value(1, i);
+                engine.put(key, big_value(1, i), 0);
+            }
+        }
+        for (int i = 0; i < num_keys; i++)
+        {
+            kvs["filler" + std::to_string(i)] = big_value(1, i);
+            engine.put("filler" + std::to_string(i), big_value(1, i), 0);
+        }
+        wait_flush(engine);
+        EXPECT_GT(engine.level_sst_count(1), 0);
+        EXPECT_EQ(scan_all(engine), kvs);
+    }
+
+    // compaction 丢弃了第一轮的所有 value，第一个 blob 文件已经被删除
+    auto blob_files = list_blob_files(test_dir);
+    EXPECT_FALSE(blob_files.empty());
+    for (auto &filename : old_blob_files)
+    {
+        EXPECT_EQ(blob_files.count(filename), 0) << filename;
+    }
+
+    LSMEngine engine(test_dir);
+    for (int i = 0; i < num_keys; i++)
+    {
+        std::string key = "key" + std::to_string(i);
+        auto res = engine.get(key, 0);
+        if (i % 4 == 0)
+        {
+            EXPECT_FALSE(res.has_value());
+        }
+        else
+        {
+            ASSERT_TRUE(res.has_value());
+            EXPECT_EQ(res->first, big_value(1, i));
+        }
+    }
+    EXPECT_EQ(scan_all(engine), kvs);
+}
+
+TEST_F(EngineTest, WriteStallTest)
+{
+    constexpr size_t max_immutable = 2;
+    constexpr int num_threads = 4;
+    constexpr int per_thread = 2000;
+    {
+        LSMEngine engine(test_dir, max_immutable, MemTableRepType::SkipList, 4 * 1024);
+
+        // 写线程在冻结表达到上限时被阻塞，冻结表数量不会超过上限
+        std::atomic<bool> done{false};
+        size_t max_frozen = 0;
+        std::thread monitor([&]
+                            {
+            while (!done)
+            {
+                max_frozen = std::max(max_frozen, engine.frozen_memtable_count());
+                std::this_thread::yield();
+            } });
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < num_threads; t++)
+        {
+            writers.emplace_back([&engine, t]
+                                 {
+                for (int i = 0; i < per_thread; i++)
+                {
+                    engine.put("key" + std::to_string(t) + "_" + std::to_string(i), "value" + std::to_string(i), 0);
+                } });
+        }
+        for (auto &writer : writers)
+        {
+            writer.join();
+        }
+        done = true;
+        monitor.join();
+
+        EXPECT_LE(max_frozen, max_immutable);
+    }
+
+    LSMEngine engine(test_dir);
+    for (int t = 0; t < num_threads; t++)
+    {
+        for (int i = 0; i < per_thread; i++)
+        {
+            auto res = engine.get("key" + std::to_string(t) + "_" + std::to_string(i), 0);
+            ASSERT_TRUE(res.has_value());
+            EXPECT_EQ(res->first, "value" + std::to_string(i));
+        }
+    }
+}
+
+TEST_F(EngineTest, BackgroundErrorTest)
+{
+    LSMEngine engine(test_dir, 1, MemTableRepType::SkipList, 4 * 1024);
+    engine.put("first", "value", 0);
+
+    // 删除数据目录，之后的刷盘无法创建 SST 文件
+    std::filesystem::remove_all(test_dir);
+
+    // 刷盘线程的异常不会终止进程，而是在之后的写操作中抛出
+    bool thrown = false;
+    for (int i = 0; i < 100000 && !thrown; i++)
+    {
+        try
+        {
+            engine.put("key" + std::to_string(i), std::string(100, 'v'), 0);
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_THROW(engine.put("after", "value", 0), std::runtime_error);
+    EXPECT_THROW(engine.remove("first", 0), std::runtime_error);
+
+    // 没有写入 SST 的数据仍然留在内存中
+    auto res = engine.get("first", 0);
+    ASSERT_TRUE(res.has_value());
+    EXPECT_EQ(res->first, "value");
+}
+
+TEST_F(EngineTest, DroppedTransactionTest)
+{
+    auto engine = std::make_shared<LSMEngine>(test_dir);
+    auto manager = std::make_shared<TranManager>(test_dir, IsolationLevel::RepeatableRead);
+    manager->set_engine(engine);
+
+    uint64_t first_id = manager->get_oldest_active_tranc_id();
+    {
+        auto tranc = manager->new_tranc(IsolationLevel::RepeatableRead);
+        tranc->put("key", "value");
+        EXPECT_EQ(manager->get_oldest_active_tranc_id(), first_id);
+        // 既没有提交也没有回滚就被丢弃
+    }
+
+    // 被丢弃的事务不再阻止旧版本的回收
+    EXPECT_GT(manager->get_oldest_active_tranc_id(), first_id);
+
+    auto running = manager->new_tranc(IsolationLevel::RepeatableRead);
+    EXPECT_EQ(manager->get_oldest_active_tranc_id(), first_id + 1);
+    running->abort();
+    EXPECT_EQ(manager->get_oldest_active_tranc_id(), first_id + 2);
 }
 
 int main(int argc, char **argv)
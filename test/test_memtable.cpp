@@ -1,5 +1,6 @@
 #include "../include/memtable/memtable.h"
 #include <gtest/gtest.h>
+#include <map>
 
 TEST(MemtableTest, BasicOperations)
 {
@@ -34,6 +35,90 @@ TEST(MemTableTest, FrozenTableOperations)
   EXPECT_EQ(memtable.get("key3", 0).get_value(), "value3");
 }
 
+TEST(MemTableTest, PopLastFrozenTable)
+{
+  Memtable memtable;
+
+  memtable.put("key1", "value1", 0);
+  memtable.frozen_cur_table();
+  memtable.put("key2", "value2", 0);
+  memtable.frozen_cur_table();
+  EXPECT_EQ(memtable.get_frozen_count(), 2);
+
+  // 移除最旧的冻结表，较新的冻结表仍然可读
+  memtable.pop_last();
+  EXPECT_EQ(memtable.get_frozen_count(), 1);
+  EXPECT_FALSE(memtable.get("key1", 0).is_valid());
+  EXPECT_EQ(memtable.get("key2", 0).get_value(), "value2");
+  EXPECT_EQ(memtable.get_frozen_size(), memtable.get_total_size());
+}
+
+TEST(MemTableTest, FlushDropsShadowedVersions)
+{
+  Memtable memtable;
+
+  memtable.put("key1", "v1", 1);
+  memtable.put("key1", "v2", 2);
+  memtable.put("key1", "v5", 5);
+  memtable.put("key2", "v1", 1);
+  memtable.put("key3", "v4", 4);
+  memtable.put("key3", "v6", 6);
+
+  // 最老的活跃事务为 3：key1 保留事务 5 和对事务 3 可见的事务 2，事务 1 的版本被遮蔽
+  SSTBuilder builder(4096, true);
+  std::string path = "test_memtable_gc.sst";
+  size_t flushed_count;
+  auto sst = memtable.flush_frozen(builder, path, 0, std::make_shared<BlockCache>(16, 2), 3, flushed_count);
+  ASSERT_NE(sst, nullptr);
+  EXPECT_EQ(flushed_count, 1);
+
+  std::vector<std::pair<std::string, uint64_t>> results;
+  for (auto it = sst->begin(0); it.is_valid(); ++it)
+  {
+    results.emplace_back((*it).first, it.get_tranc_id());
+  }
+  std::vector<std::pair<std::string, uint64_t>> expected = {
+      {"key1", 5}, {"key1", 2}, {"key2", 1}, {"key3", 6}, {"key3", 4}};
+  EXPECT_EQ(results, expected);
+
+  sst->del_sst();
+}
+
+TEST(MemTableTest, FlushMergesFrozenTables)
+{
+  Memtable memtable;
+
+  memtable.put("key1", "old", 1);
+  memtable.put("key3", "v3", 1);
+  memtable.frozen_cur_table();
+  memtable.put("key1", "new", 1); // 与旧表中的 (key1, 1) 重复，以较新的表为准
+  memtable.put("key2", "v2", 2);
+  memtable.frozen_cur_table();
+  memtable.put("key4", "v4", 3); // 活跃表不参与刷盘
+
+  SSTBuilder builder(4096, true);
+  std::string path = "test_memtable_merge.sst";
+  size_t flushed_count;
+  auto sst = memtable.flush_frozen(builder, path, 0, std::make_shared<BlockCache>(16, 2), 0, flushed_count);
+  ASSERT_NE(sst, nullptr);
+  EXPECT_EQ(flushed_count, 2);
+
+  std::vector<std::pair<std::string, std::string>> results;
+  for (auto it = sst->begin(0); it.is_valid(); ++it)
+  {
+    results.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> expected = {
+      {"key1", "new"}, {"key2", "v2"}, {"key3", "v3"}};
+  EXPECT_EQ(results, expected);
+
+  memtable.pop_last(flushed_count);
+  EXPECT_EQ(memtable.get_frozen_count(), 0);
+  EXPECT_EQ(memtable.get("key4", 0).get_value(), "v4");
+
+  sst->del_sst();
+}
+
 TEST(MemTableTest, LargeScaleOperations)
 {
   Memtable memtable;
@@ -92,6 +177,85 @@ TEST(MemTableTest, IteratorComplexOperations)
   EXPECT_EQ(results2[2].first, "key4");
 }
 
+TEST(MemTableTest, IteratorTrancIdAndPredicate)
+{
+  Memtable memtable;
+
+  memtable.put("key1", "value1_1", 1);
+  memtable.put("key3", "value3_1", 1);
+  memtable.frozen_cur_table();
+  memtable.put("key1", "value1_3", 3);
+  memtable.put("key2", "value2_2", 2);
+  memtable.remove("key3", 2);
+
+  // 只能看到事务 id 不大于 2 的记录
+  std::vector<std::pair<std::string, std::string>> results;
+  for (auto it = memtable.begin(2); it != memtable.end(2); ++it)
+  {
+    results.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> expected = {
+      {"key1", "value1_1"}, {"key2", "value2_2"}};
+  EXPECT_EQ(results, expected);
+
+  auto result = memtable.iter_monotony_predicate(0, [](const std::string &key)
+                                                 {
+    if (key < "key1") {
+      return 1;
+    }
+    if (key > "key2") {
+      return -1;
+    }
+    return 0; });
+  ASSERT_TRUE(result.has_value());
+  auto [it_begin, it_end] = result.value();
+  results.clear();
+  for (; it_begin != it_end; ++it_begin)
+  {
+    results.push_back(*it_begin);
+  }
+  expected = {{"key1", "value1_3"}, {"key2", "value2_2"}};
+  EXPECT_EQ(results, expected);
+}
+
+TEST(MemTableTest, GetBatch)
+{
+  Memtable memtable;
+
+  for (int i = 0; i < 100; i++)
+  {
+    memtable.put("key" + std::to_string(i), "old" + std::to_string(i), 0);
+  }
+  memtable.frozen_cur_table();
+  for (int i = 0; i < 100; i += 2)
+  {
+    memtable.put("key" + std::to_string(i), "new" + std::to_string(i), 0);
+  }
+  memtable.remove("key1", 0);
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 110; i++)
+  {
+    keys.push_back("key" + std::to_string(i));
+  }
+  auto results = memtable.get_batch(keys, 0);
+  ASSERT_EQ(results.size(), keys.size());
+  for (int i = 0; i < 110; i++)
+  {
+    // 结果与逐个查找一致
+    auto single = memtable.get(keys[i], 0);
+    ASSERT_EQ(results[i].is_valid(), single.is_valid());
+    if (single.is_valid())
+    {
+      EXPECT_EQ(results[i].get_value(), single.get_value());
+    }
+  }
+  EXPECT_EQ(results[2].get_value(), "new2");
+  EXPECT_EQ(results[3].get_value(), "old3");
+  EXPECT_EQ(results[1].get_value(), "");
+  EXPECT_FALSE(results[105].is_valid());
+}
+
 TEST(MemTableTest, ConcurrentOperations)
 {
   Memtable memtable;
@@ -288,6 +452,75 @@ TEST(MemTableTest, ConcurrentOperations)
   EXPECT_LE(final_size, num_writers * num_operations); // 大小不应超过最大可能值
 }
 
+// 不同存储结构的内存表行为应当一致
+class MemTableRepTest : public ::testing::TestWithParam<MemTableRepType>
+{
+};
+
+TEST_P(MemTableRepTest, Operations)
+{
+  Memtable memtable(GetParam());
+
+  // 相互为前缀的 key，以及大量共享前缀的 key(覆盖 ART 的路径压缩和节点扩容)
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 1000; i++)
+  {
+    std::string key = "user:" + std::to_string(i * 7919 % 1000);
+    memtable.put(key, "v" + std::to_string(i), 1);
+    expected[key] = "v" + std::to_string(i);
+  }
+  for (std::string key : {"a", "ab", "abc", "abd", "b"})
+  {
+    memtable.put(key, key, 1);
+    expected[key] = key;
+  }
+  memtable.put("ab", "ab_2", 2);
+  memtable.remove("abc", 2);
+  memtable.frozen_cur_table();
+  memtable.put("user:5", "new", 3);
+
+  EXPECT_EQ(memtable.get("ab", 1).get_value(), "ab");
+  EXPECT_EQ(memtable.get("ab", 0).get_value(), "ab_2");
+  EXPECT_EQ(memtable.get("abc", 1).get_value(), "abc");
+  EXPECT_EQ(memtable.get("abc", 0).get_value(), "");
+  EXPECT_EQ(memtable.get("user:5", 0).get_value(), "new");
+  EXPECT_FALSE(memtable.get("abe", 0).is_valid());
+  EXPECT_FALSE(memtable.get("user:", 0).is_valid());
+
+  // 遍历结果按 key 有序，每个 key 只出现一次，已删除的 key 不出现
+  expected["ab"] = "ab_2";
+  expected.erase("abc");
+  expected["user:5"] = "new";
+  std::vector<std::pair<std::string, std::string>> results;
+  for (auto it = memtable.begin(0); it != memtable.end(0); ++it)
+  {
+    results.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> all(expected.begin(), expected.end());
+  EXPECT_EQ(results, all);
+
+  auto result = memtable.iter_monotony_predicate(0, [](const std::string &key)
+                                                 {
+    if (key < "ab") {
+      return 1;
+    }
+    if (key > "abd") {
+      return -1;
+    }
+    return 0; });
+  ASSERT_TRUE(result.has_value());
+  results.clear();
+  for (auto [it_begin, it_end] = result.value(); it_begin != it_end; ++it_begin)
+  {
+    results.push_back(*it_begin);
+  }
+  std::vector<std::pair<std::string, std::string>> range = {{"ab", "ab_2"}, {"abd", "abd"}};
+  EXPECT_EQ(results, range);
+}
+
+INSTANTIATE_TEST_SUITE_P(Reps, MemTableRepTest,
+                         ::testing::Values(MemTableRepType::SkipList, MemTableRepType::HashTable, MemTableRepType::Art));
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -1,5 +1,6 @@
 #include "../include/skiplist/skiplist.h"
 #include <gtest/gtest.h>
+#include <thread>
 
 TEST(SkipListTest, BasicOperations) {
   SkipList skiplist;
@@ -34,6 +35,162 @@ TEST(SkipListTest, LargeScaleSetAndGet) {
   }
 }
 
+TEST(SkipListTest, TrancIdAndPredicate) {
+  SkipList skiplist;
+
+  skiplist.put("key1", "value1_1", 1);
+  skiplist.put("key1", "value1_3", 3);
+  skiplist.put("key2", "value2", 2);
+  skiplist.put("key3", "value3", 1);
+
+  // 相同的 key 按事务 id 从大到小排列
+  EXPECT_EQ(skiplist.get("key1", 0).get_value(), "value1_3");
+  EXPECT_EQ(skiplist.get("key1", 2).get_value(), "value1_1");
+  EXPECT_FALSE(skiplist.get("key2", 1).is_valid());
+
+  auto result = skiplist.iters_monotony_predicate([](const std::string &key) {
+    if (key < "key1") {
+      return 1;
+    }
+    if (key > "key2") {
+      return -1;
+    }
+    return 0;
+  });
+  ASSERT_TRUE(result.has_value());
+  auto [it_begin, it_end] = result.value();
+  std::vector<std::string> values;
+  for (; it_begin != it_end; ++it_begin) {
+    values.push_back(it_begin.get_value());
+  }
+  std::vector<std::string> expected = {"value1_3", "value1_1", "value2"};
+  EXPECT_EQ(values, expected);
+
+  // 迭代器持有 arena，clear 之后仍然可以安全访问
+  auto it = skiplist.begin();
+  skiplist.clear();
+  EXPECT_EQ(it.get_key(), "key1");
+  EXPECT_FALSE(skiplist.begin().is_valid());
+}
+
+TEST(SkipListTest, ConcurrentPut) {
+  SkipList skiplist;
+  const int thread_num = 4;
+  const int per_thread = 2000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&skiplist, t]() {
+      for (int i = 0; i < per_thread; i++) {
+        // 不同线程的 key 交错分布，增加在同一位置竞争插入的概率
+        std::string key = "key" + std::to_string(i * thread_num + t);
+        skiplist.put(key, "value" + std::to_string(t), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < thread_num * per_thread; i++) {
+    auto it = skiplist.get("key" + std::to_string(i), 0);
+    ASSERT_TRUE(it.is_valid());
+    EXPECT_EQ(it.get_value(), "value" + std::to_string(i % thread_num));
+  }
+
+  int count = 0;
+  std::string prev_key;
+  for (auto it = skiplist.begin(); it != skiplist.end(); ++it) {
+    if (count > 0) {
+      EXPECT_LT(prev_key, it.get_key());
+    }
+    prev_key = it.get_key();
+    count++;
+  }
+  EXPECT_EQ(count, thread_num * per_thread);
+}
+
+TEST(SkipListTest, BloomFilter) {
+  SkipList skiplist;
+  for (int i = 0; i < 1000; i++) {
+    skiplist.put("key" + std::to_string(i), "value", 0);
+  }
+
+  // 插入过的 key 一定能通过过滤器
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(skiplist.may_contain("key" + std::to_string(i)));
+  }
+
+  // 不存在的 key 绝大部分会被过滤掉
+  int false_positive = 0;
+  for (int i = 1000; i < 11000; i++) {
+    if (skiplist.may_contain("key" + std::to_string(i))) {
+      false_positive++;
+    }
+  }
+  EXPECT_LT(false_positive, 100);
+
+  skiplist.clear();
+  EXPECT_FALSE(skiplist.may_contain("key1"));
+
+  // 大小上限很小的跳表使用最小的过滤器，插入过的 key 同样一定能通过
+  SkipList small(16, 4 * 1024);
+  for (int i = 0; i < 1000; i++) {
+    small.put("key" + std::to_string(i), "value", 0);
+  }
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(small.may_contain("key" + std::to_string(i)));
+  }
+}
+
+TEST(SkipListTest, PutBatch) {
+  SkipList skiplist;
+  skiplist.put("key2", "old2", 0);
+  skiplist.put("key5", "old5", 0);
+
+  std::vector<std::pair<std::string_view, std::string_view>> kvs;
+  std::vector<std::string> keys;
+  for (int i = 9; i >= 0; i--) {
+    keys.push_back("key" + std::to_string(i));
+  }
+  for (auto &key : keys) {
+    kvs.emplace_back(key, key);
+  }
+  // 同一个 key 在批量中出现多次时，后面的覆盖前面的
+  kvs.emplace_back("key3", "new3");
+  skiplist.put_batch(kvs, 0);
+
+  std::vector<std::string> values;
+  for (auto it = skiplist.begin(); it != skiplist.end(); ++it) {
+    values.push_back(it.get_value());
+  }
+  std::vector<std::string> expected = {"key0", "key1", "key2", "new3", "key4",
+                                       "key5", "key6", "key7", "key8", "key9"};
+  EXPECT_EQ(values, expected);
+}
+
+TEST(SkipListTest, KeyPrefixOrdering) {
+  SkipList skiplist;
+  // 覆盖内联前缀的边界：不足 8 字节、包含 '\0'、前 8 个字节相同
+  std::vector<std::string> keys = {
+      "",          "a",         std::string("a\0", 2), std::string("a\0\0", 3),
+      "ab",        "abcdefgh",  "abcdefgh0",           "abcdefghij",
+      "abcdefgi",  "b",         "\xff\xff"};
+  for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+    skiplist.put(*it, "v" + *it, 0);
+  }
+
+  std::vector<std::string> result;
+  for (auto it = skiplist.begin(); it != skiplist.end(); ++it) {
+    result.push_back(it.get_key());
+  }
+  EXPECT_EQ(result, keys);
+  for (auto &key : keys) {
+    EXPECT_EQ(skiplist.get(key, 0).get_value(), "v" + key);
+  }
+  EXPECT_FALSE(skiplist.get("abcdefg", 0).is_valid());
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
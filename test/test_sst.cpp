@@ -1,6 +1,7 @@
 #include "../include/const.h"
 #include "../include/sst/sst.h"
 #include "../include/sst/sst_iterator.h"
+#include "../include/sst/table_cache.h"
 #include <filesystem>
 #include <gtest/gtest.h>
 
@@ -150,7 +151,7 @@ TEST_F(SSTTest, ReopenSST)
         std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
 
     // 重新打开SST
-    FileObj file = FileObj::open("test_data/test.sst", true);
+    FileObj file = FileObj::open("test_data/test.sst", false);
     auto reopened_sst = SST::open(1, std::move(file), block_cache);
 
     // 验证数据一致性
@@ -159,6 +160,62 @@ TEST_F(SSTTest, ReopenSST)
     EXPECT_EQ(sst->num_blocks(), reopened_sst->num_blocks());
 }
 
+// 读选项控制单次读取是否校验数据块，不影响同一个 SST 上的其他读取
+TEST_F(SSTTest, ReadOptionsVerifyChecksums)
+{
+    create_test_sst(4096, 100);
+
+    // 修改第一个数据块中 value50 的一个字节
+    std::vector<uint8_t> bytes;
+    {
+        auto file = FileObj::open("test_data/test.sst", false);
+        bytes = file.read_to_slice(0, file.size());
+    }
+    std::string content(bytes.begin(), bytes.end());
+    size_t pos = content.find("value50");
+    ASSERT_NE(pos, std::string::npos);
+    bytes[pos + 5] = '6';
+    std::filesystem::remove("test_data/test.sst");
+    FileObj::create_and_write("test_data/test.sst", bytes);
+
+    auto open_sst = []
+    {
+        auto block_cache = std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+        return SST::open(1, FileObj::open("test_data/test.sst", false), block_cache);
+    };
+
+    // 默认校验，损坏的数据块读不出来
+    auto sst = open_sst();
+    EXPECT_THROW(sst->begin(0), std::runtime_error);
+    EXPECT_FALSE(sst->get("key50", 0).is_valid());
+
+    // 关闭校验后按原样读出
+    ReadOptions options;
+    options.verify_checksums = false;
+    sst = open_sst();
+    auto it = sst->get("key50", 0, options);
+    ASSERT_TRUE(it.is_valid());
+    EXPECT_EQ(it->second, "value60");
+}
+
+// 被布隆过滤器排除的查找不读取任何 block
+TEST_F(SSTTest, BloomMissReadsNoBlock)
+{
+    create_test_sst(256, 1000);
+    auto block_cache =
+        std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+    auto sst = SST::open(1, FileObj::open("test_data/test.sst", false), block_cache);
+
+    BufferPool::global().reset_stats();
+    for (int i = 0; i < 1000; i++)
+    {
+        // 比所有 key 都大，即使通过了布隆过滤器也只需要查找索引
+        EXPECT_FALSE(sst->get("zzz" + std::to_string(i), 0).is_valid());
+    }
+    EXPECT_EQ(BufferPool::global().stats().acquires, 0);
+    EXPECT_EQ(block_cache->hit_rate(), 0.0);
+}
+
 // 测试大文件
 TEST_F(SSTTest, LargeSST)
 {
@@ -207,6 +264,347 @@ TEST_F(SSTTest, LargeSST)
     }
 }
 
+// 测试数据块压缩
+TEST_F(SSTTest, CompressedSST)
+{
+    auto block_cache =
+        std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+    SSTBuilder plain_builder(4096, true);
+    SSTBuilder lz_builder(4096, true, CompressionType::LZ);
+    for (int i = 0; i < 1000; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "key%04d", i);
+        // 文本类的 value，重复内容较多
+        std::string value = "{\"name\": \"user" + std::to_string(i) + "\", \"status\": \"active\", \"status\": \"active\"}";
+        plain_builder.add(key, value, 1);
+        lz_builder.add(key, value, 1);
+    }
+    auto plain = plain_builder.build(1, "test_data/plain.sst", block_cache);
+    auto compressed = lz_builder.build(2, "test_data/lz.sst", block_cache);
+    EXPECT_LT(compressed->sst_size(), plain->sst_size());
+
+    for (int i = 0; i < 1000; i += 7)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "key%04d", i);
+        auto it = compressed->get(key, 0);
+        ASSERT_TRUE(it.is_valid()) << key;
+        EXPECT_EQ(it->second, "{\"name\": \"user" + std::to_string(i) + "\", \"status\": \"active\", \"status\": \"active\"}");
+    }
+
+    int count = 0;
+    for (auto it = compressed->begin(0); it.is_valid(); ++it)
+    {
+        count++;
+    }
+    EXPECT_EQ(count, 1000);
+}
+
+// 测试键值分离：大 value 写入 blob 文件，compaction 后删除或搬运 blob 文件
+TEST_F(SSTTest, BlobSeparation)
+{
+    auto block_cache =
+        std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+    // 每个 blob 文件放 4 个 value
+    auto blob_store = std::make_shared<BlobStore>("test_data", LSM_BLOB_VALUE_THRESHOLD * 4);
+    auto big_value = [](int i)
+    { return std::string(LSM_BLOB_VALUE_THRESHOLD, 'a' + i % 26) + std::to_string(i); };
+    std::string tagged = std::string(1, LSM_BLOB_VALUE_TAG) + "small";
+
+    SSTBuilder builder(4096, true);
+    builder.set_blob_store(blob_store);
+    for (int i = 0; i < 40; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "key%04d", i);
+        builder.add(key, i % 2 == 0 ? big_value(i) : tagged, 1);
+    }
+    auto sst = builder.build(1, "test_data/blob.sst", block_cache);
+    EXPECT_EQ(blob_store->file_count(), 5);
+
+    // SST 中保存的是引用，解析后是原来的 value
+    for (int i = 0; i < 40; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "key%04d", i);
+        auto it = sst->get(key, 0);
+        ASSERT_TRUE(it.is_valid()) << key;
+        EXPECT_LT(it->second.size(), LSM_BLOB_VALUE_THRESHOLD);
+        EXPECT_EQ(blob_store->resolve(it->second), i % 2 == 0 ? big_value(i) : tagged);
+    }
+
+    // 引用统计随 SST 一起持久化
+    auto reopened = SST::open(1, FileObj::open("test_data/blob.sst", false), block_cache);
+    EXPECT_EQ(reopened->get_blob_refs(), sst->get_blob_refs());
+    blob_store->collect_garbage(sst->get_blob_refs());
+    EXPECT_EQ(blob_store->file_count(), 5);
+
+    // 模拟 compaction 丢弃前 30 个 key：前 3 个 blob 文件不再被引用，第 4 个只剩一半
+    SSTBuilder compacted_builder(4096, true);
+    compacted_builder.set_blob_store(blob_store);
+    for (auto it = sst->begin(0); it.is_valid(); ++it)
+    {
+        if (it->first >= "key0030")
+        {
+            compacted_builder.add_encoded(it->first, it->second, it.get_tranc_id());
+        }
+    }
+    auto compacted = compacted_builder.build(2, "test_data/compacted.sst", block_cache);
+    sst->del_sst();
+    blob_store->collect_garbage(compacted->get_blob_refs());
+    EXPECT_EQ(blob_store->file_count(), 2);
+
+    // 再次 compaction 时第 4 个文件中存活的 value 被搬到新文件，之后它也可以删除
+    SSTBuilder relocated_builder(4096, true);
+    relocated_builder.set_blob_store(blob_store);
+    for (auto it = compacted->begin(0); it.is_valid(); ++it)
+    {
+        relocated_builder.add_encoded(it->first, it->second, it.get_tranc_id());
+    }
+    auto relocated = relocated_builder.build(3, "test_data/relocated.sst", block_cache);
+    compacted->del_sst();
+    blob_store->collect_garbage(relocated->get_blob_refs());
+    EXPECT_EQ(blob_store->file_count(), 2);
+    EXPECT_EQ(relocated->get_blob_refs().count(3), 0);
+
+    for (int i = 30; i < 40; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "key%04d", i);
+        auto it = relocated->get(key, 0);
+        ASSERT_TRUE(it.is_valid()) << key;
+        EXPECT_EQ(blob_store->resolve(it->second), i % 2 == 0 ? big_value(i) : tagged);
+    }
+}
+
+// 测试分区索引
+TEST_F(SSTTest, PartitionedIndex)
+{
+    auto block_cache =
+        std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+    // 长 key 的公共前缀很长，分隔 key 只需要保留到第一个不同的字节
+    std::string prefix(100, 'p');
+    auto make_key = [&](int i)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%06d", i);
+        return prefix + buf + std::string(50, 's');
+    };
+
+    SSTBuilder flat_builder(1024, true);
+    flat_builder.set_index_partition_size(0);
+    SSTBuilder builder(1024, true);
+    builder.set_index_partition_size(512);
+    for (int i = 0; i < 20000; i += 2)
+    {
+        flat_builder.add(make_key(i), "value" + std::to_string(i));
+        builder.add(make_key(i), "value" + std::to_string(i));
+    }
+    auto flat = flat_builder.build(1, "test_data/flat.sst", block_cache);
+    auto sst = builder.build(2, "test_data/partitioned.sst", block_cache);
+    ASSERT_GT(sst->num_blocks(), 100);
+    EXPECT_EQ(sst->num_blocks(), flat->num_blocks());
+    // 顶层索引只有分区的分隔 key
+    EXPECT_LT(sst->index_memory_size() * 4, flat->index_memory_size());
+
+    auto reopened = SST::open(3, FileObj::open("test_data/partitioned.sst", false), block_cache);
+    EXPECT_EQ(reopened->num_blocks(), sst->num_blocks());
+    EXPECT_EQ(reopened->get_first_key(), make_key(0));
+    EXPECT_EQ(reopened->get_last_key(), make_key(19998));
+
+    for (auto &table : {flat, sst, reopened})
+    {
+        for (int i = 0; i < 20000; i++)
+        {
+            auto key = make_key(i);
+            auto it = table->get(key, 0);
+            if (i % 2 == 0)
+            {
+                ASSERT_TRUE(it.is_valid()) << i;
+                EXPECT_EQ(it->second, "value" + std::to_string(i));
+                EXPECT_EQ(table->find_block_idx(key), flat->find_block_idx(key));
+            }
+            else
+            {
+                EXPECT_FALSE(it.is_valid() && it->first == key) << i;
+            }
+        }
+        EXPECT_EQ(table->find_block_idx(prefix + "999999"), size_t(-1));
+
+        size_t count = 0;
+        for (auto it = table->begin(0); it.is_valid(); ++it)
+        {
+            EXPECT_EQ(it->first, make_key(count * 2));
+            count++;
+        }
+        EXPECT_EQ(count, 10000);
+    }
+}
+
+// 测试谓词查询只读取与区间重叠的 block
+TEST_F(SSTTest, PredicateSeek)
+{
+    auto block_cache =
+        std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+    SSTBuilder builder(256, true);
+    for (int i = 0; i < 5000; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "key%05d", i);
+        builder.add(key, "value" + std::to_string(i));
+    }
+    auto sst = builder.build(1, "test_data/predicate.sst", block_cache);
+    ASSERT_GT(sst->num_blocks(), 50);
+
+    // 返回区间 [lo, hi] 中的 key 数量
+    auto count_range = [&](const std::string &lo, const std::string &hi) -> int
+    {
+        auto result = sst_iters_monotony_predicate(0, sst, [&](const std::string &key)
+                                                   {
+            if (key < lo)
+            {
+                return 1;
+            }
+            return key > hi ? -1 : 0; });
+        if (!result.has_value())
+        {
+            return 0;
+        }
+        auto [it, end] = result.value();
+        int count = 0;
+        for (; it != end && it.is_valid(); ++it)
+        {
+            EXPECT_GE(it->first, lo);
+            EXPECT_LE(it->first, hi);
+            count++;
+        }
+        return count;
+    };
+
+    // 新的缓存中每个 block 只会从文件读取一次
+    BufferPool::global().reset_stats();
+    EXPECT_EQ(count_range("key01000", "key01099"), 100);
+    EXPECT_LT(BufferPool::global().stats().acquires, sst->num_blocks() / 5);
+
+    EXPECT_EQ(count_range("a", "b"), 0);
+    EXPECT_EQ(count_range("z", "zz"), 0);
+    EXPECT_EQ(count_range("key01000a", "key01000z"), 0);
+    EXPECT_EQ(count_range("key04990", "z"), 10);
+    EXPECT_EQ(count_range("a", "key00009"), 10);
+
+    // 区间恰好在 block 的边界上结束或开始
+    int first_idx = 0;
+    for (size_t i = 0; i < 5; i++)
+    {
+        auto block = sst->read_block(i);
+        std::string last_key;
+        int block_entries = 0;
+        for (auto it = block->begin(); it != block->end(); ++it)
+        {
+            last_key = it->first;
+            block_entries++;
+        }
+        EXPECT_EQ(count_range("key00000", last_key), first_idx + block_entries);
+        EXPECT_EQ(count_range(block->get_first_key(), "key09999"), 5000 - first_idx);
+        first_idx += block_entries;
+    }
+}
+
+// 缓存很小时，迭代过程中结束位置所在的 block 会被淘汰后重新读取
+TEST_F(SSTTest, PredicateSmallCache)
+{
+    auto block_cache = std::make_shared<BlockCache>(16, LSM_BLOCK_CACHE_K);
+    SSTBuilder builder(256, true);
+    for (int i = 0; i < 5000; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "key%05d", i);
+        builder.add(key, "value" + std::to_string(i));
+    }
+    auto sst = builder.build(1, "test_data/small_cache.sst", block_cache);
+    ASSERT_GT(sst->num_blocks(), 100);
+
+    // 区间在第 end_block 个 block 的末尾结束，跨越的 block 数量远大于缓存容量
+    size_t end_block = 80;
+    auto block = sst->read_block(end_block);
+    std::string last_key;
+    for (auto it = block->begin(); it != block->end(); ++it)
+    {
+        last_key = it->first;
+    }
+    int expected = std::stoi(last_key.substr(3)) + 1;
+
+    auto result = sst_iters_monotony_predicate(0, sst, [&](const std::string &key)
+                                               { return key > last_key ? -1 : 0; });
+    ASSERT_TRUE(result.has_value());
+    auto [it, end] = result.value();
+    int count = 0;
+    for (; it != end && it.is_valid(); ++it)
+    {
+        ASSERT_LE(it->first, last_key);
+        count++;
+    }
+    EXPECT_EQ(count, expected);
+
+    // 区间一直到 SST 的末尾
+    result = sst_iters_monotony_predicate(0, sst, [&](const std::string &key)
+                                          { return key < last_key ? 1 : 0; });
+    ASSERT_TRUE(result.has_value());
+    std::tie(it, end) = result.value();
+    count = 0;
+    for (; it != end && it.is_valid(); ++it)
+    {
+        count++;
+    }
+    EXPECT_EQ(count, 5000 - expected + 1);
+    EXPECT_TRUE(it == end);
+}
+
+// 测试 SST 的 LRU 缓存
+TEST_F(SSTTest, TableCache)
+{
+    auto block_cache =
+        std::make_shared<BlockCache>(LSM_BLOCK_CACHE_CAPACITY, LSM_BLOCK_CACHE_K);
+    TableCache table_cache("test_data", 2, block_cache);
+    for (size_t id = 0; id < 4; id++)
+    {
+        SSTBuilder builder(1024, true);
+        builder.add("key" + std::to_string(id), "value" + std::to_string(id));
+        builder.build(id, table_cache.get_sst_path(id), block_cache);
+    }
+
+    // 第一次访问时打开，之后命中缓存
+    EXPECT_EQ(table_cache.get(0)->get_first_key(), "key0");
+    EXPECT_EQ(table_cache.get(1)->get_first_key(), "key1");
+    EXPECT_EQ(table_cache.get(0)->get_sst_id(), 0);
+    EXPECT_EQ(table_cache.open_count(), 2);
+
+    // 超过容量时淘汰最久没有使用的 1
+    EXPECT_EQ(table_cache.get(2)->get_first_key(), "key2");
+    EXPECT_EQ(table_cache.size(), 2);
+    table_cache.get(0);
+    EXPECT_EQ(table_cache.open_count(), 3);
+    table_cache.get(1);
+    EXPECT_EQ(table_cache.open_count(), 4);
+
+    // 被淘汰的 SST 仍然可以通过持有的引用读取
+    auto sst = table_cache.get(3);
+    table_cache.get(0);
+    table_cache.get(1);
+    auto it = sst->get("key3", 0);
+    ASSERT_TRUE(it.is_valid());
+    EXPECT_EQ(it->second, "value3");
+
+    // 删除打开的和没有打开的 SST 都会删除文件
+    table_cache.remove(0);
+    table_cache.remove(2);
+    EXPECT_FALSE(std::filesystem::exists(table_cache.get_sst_path(0)));
+    EXPECT_FALSE(std::filesystem::exists(table_cache.get_sst_path(2)));
+    EXPECT_EQ(table_cache.size(), 1);
+    EXPECT_THROW(table_cache.get(2), std::runtime_error);
+}
+
 // TEST_F(SSTTest, LargeSSTPredicate) {
 //   SSTBuilder builder(4096, true); // 4KB blocks
 //   auto block_cache =
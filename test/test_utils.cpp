@@ -1,6 +1,10 @@
 #include "../include/utils/file.h"
+#include "../include/utils/compression.h"
+#include "../include/utils/crc32c.h"
+#include "../include/utils/buffer_pool.h"
 #include <filesystem>
 #include <string>
+#include <thread>
 #include <vector>
 #include <gtest/gtest.h>
 
@@ -31,6 +35,126 @@ TEST_F(FileTest, BasicWriteAndRead)
     auto read_buf = file_read.read_to_slice(1, 2);
 }
 
+TEST(CRC32CTest, KnownValues)
+{
+    std::string digits = "123456789";
+    EXPECT_EQ(crc32c(digits.data(), digits.size()), 0xe3069283u);
+    std::vector<uint8_t> zeros(32, 0);
+    EXPECT_EQ(crc32c(zeros.data(), zeros.size()), 0x8a9136aau);
+
+    // 分段计算与整体计算结果相同
+    std::string text(1000, 'x');
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        text[i] = static_cast<char>(i * 7);
+    }
+    uint32_t partial = crc32c(text.data(), 333);
+    partial = crc32c(text.data() + 333, text.size() - 333, partial);
+    EXPECT_EQ(partial, crc32c(text.data(), text.size()));
+}
+
+TEST(CompressionTest, LZRoundTrip)
+{
+    std::vector<std::string> inputs = {
+        std::string(10000, 'a'),
+        "abcabcabcabcabcabcabcabcabcabc",
+        "key0001value0001key0002value0002key0003value0003key0004value0004",
+    };
+    std::string text;
+    for (int i = 0; i < 2000; i++)
+    {
+        text += "field" + std::to_string(i % 37) + "=" + std::to_string(i) + ";";
+    }
+    inputs.push_back(text);
+
+    for (auto &input : inputs)
+    {
+        auto src = reinterpret_cast<const uint8_t *>(input.data());
+        std::vector<uint8_t> out;
+        ASSERT_EQ(Compression::compress(CompressionType::LZ, src, input.size(), out), CompressionType::LZ);
+        EXPECT_LT(out.size(), input.size());
+        auto restored = Compression::decompress(CompressionType::LZ, out.data(), out.size());
+        EXPECT_EQ(std::string(restored.begin(), restored.end()), input);
+
+        // 截断的数据不能被解压
+        EXPECT_THROW(Compression::decompress(CompressionType::LZ, out.data(), out.size() / 2), std::runtime_error);
+    }
+
+    // 无法压缩的数据不输出任何内容
+    std::vector<uint8_t> random_bytes(256);
+    for (size_t i = 0; i < random_bytes.size(); i++)
+    {
+        random_bytes[i] = static_cast<uint8_t>(i * 131 + (i >> 3) * 17);
+    }
+    std::vector<uint8_t> out;
+    EXPECT_EQ(Compression::compress(CompressionType::LZ, random_bytes.data(), random_bytes.size(), out), CompressionType::None);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(BufferPoolTest, ReuseBySizeClass)
+{
+    BufferPool pool(1024 * 1024);
+
+    auto buf = pool.acquire(3000);
+    EXPECT_EQ(buf.size(), 3000);
+    EXPECT_EQ(buf.capacity(), 4096);
+    const uint8_t *addr = buf.data();
+    pool.release(std::move(buf));
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(pool.stats().pooled_bytes, 4096);
+
+    // 同一级别的请求复用归还的缓冲区，其他级别重新分配
+    auto same = pool.acquire(4000);
+    EXPECT_EQ(same.data(), addr);
+    EXPECT_EQ(same.size(), 4000);
+    auto other = pool.acquire(5000);
+    auto small = pool.acquire(100);
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.acquires, 4);
+    EXPECT_EQ(stats.reuses, 1);
+    EXPECT_EQ(stats.allocations, 3);
+    EXPECT_EQ(stats.pooled_bytes, 0);
+
+    // 太小的缓冲区不进入池，超出容量上限的直接释放
+    pool.release(std::move(small));
+    EXPECT_EQ(pool.stats().discards, 1);
+    pool.set_capacity(4096);
+    pool.release(std::move(same));
+    pool.release(std::move(other));
+    stats = pool.stats();
+    EXPECT_EQ(stats.releases, 2);
+    EXPECT_EQ(stats.discards, 2);
+    EXPECT_EQ(stats.pooled_bytes, 4096);
+}
+
+TEST(BufferPoolTest, ConcurrentReleaseRespectsCapacity)
+{
+    const size_t capacity = 64 * 1024;
+    BufferPool pool(capacity);
+
+    // 多个线程同时归还不同级别的缓冲区，池中的总容量不会超过上限
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&pool, t]
+                             {
+            for (int i = 0; i < 1000; i++)
+            {
+                pool.release(pool.acquire(1024 << ((t + i) % 5)));
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto stats = pool.stats();
+    EXPECT_LE(stats.pooled_bytes, capacity);
+    EXPECT_EQ(stats.acquires, stats.reuses + stats.allocations);
+    EXPECT_EQ(stats.releases + stats.discards, stats.acquires);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
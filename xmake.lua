@@ -48,6 +48,7 @@ target("memtable")
 target("block")
     set_kind("static") -- 静态库
     add_files("src/block/*.cpp")
+    add_deps("utils")
     add_includedirs("include", {public = true})
 
 target("sst")
@@ -137,6 +138,44 @@ target("test_engine")
     add_deps("engine")
     add_packages("gtest")
 
+--- 性能测试
+
+target("bench_memtable")
+    set_kind("binary")
+    set_group("benchmarks")
+    add_files("benchmark/bench_memtable.cpp")
+    add_deps("memtable", "skiplist", "iterator", "sst", "block", "utils")
+
+target("bench_put_batch")
+    set_kind("binary")
+    set_group("benchmarks")
+    add_files("benchmark/bench_put_batch.cpp")
+    add_deps("skiplist")
+
+target("bench_skiplist_keys")
+    set_kind("binary")
+    set_group("benchmarks")
+    add_files("benchmark/bench_skiplist_keys.cpp")
+    add_deps("skiplist")
+
+target("bench_memtable_rep")
+    set_kind("binary")
+    set_group("benchmarks")
+    add_files("benchmark/bench_memtable_rep.cpp")
+    add_deps("memtable", "skiplist", "iterator", "sst", "block", "utils")
+
+target("bench_block_search")
+    set_kind("binary")
+    set_group("benchmarks")
+    add_files("benchmark/bench_block_search.cpp")
+    add_deps("block", "utils")
+
+target("bench_block_read")
+    set_kind("binary")
+    set_group("benchmarks")
+    add_files("benchmark/bench_block_read.cpp")
+    add_deps("sst", "block", "utils")
+
 target("server")
     set_kind("binary")
     add_files("server/src/*.cpp")